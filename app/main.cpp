@@ -1,6 +1,241 @@
 #include "modelconv/modelconv.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+namespace {
+void PrintUsage(const char* const app_name) {
+  printf("usage: %s <input_filepath> <output_dir> [options]\n", app_name);
+  printf("       %s --batch <list_file|directory|glob> <output_dir> [options]\n", app_name);
+  printf("  --jobs <n>                   worker threads in batch mode (default: hardware concurrency)\n");
+  printf("  --scene-jobs <n>             worker threads within a scene (default: hardware concurrency, 1 in batch mode)\n");
+  printf("  --memory-budget-mb <n>       bound estimated memory of scenes in flight in batch mode\n");
+  printf("  --post-process <preset>      fast, default or thorough assimp post-process steps\n");
+  printf("  --enable-step <name>         add an assimp post-process step, e.g. JoinIdenticalVertices\n");
+  printf("  --disable-step <name>        remove an assimp post-process step from the preset\n");
+  printf("  --no-direct-gltf             always import gltf with assimp (direct import applies to the fast and default presets)\n");
+  printf("  --merge-static               bake transforms of single-instance meshes and merge them per material\n");
+  printf("  --batch-max-vertices <n>     max vertices per merged mesh (default 65535)\n");
+  printf("  --no-optimize                skip vertex cache/overdraw/vertex fetch optimization\n");
+  printf("  --meshlet                    build meshlets with culling bounds\n");
+  printf("  --meshlet-max-vertices <n>   max vertices per meshlet (default 64)\n");
+  printf("  --meshlet-max-triangles <n>  max triangles per meshlet (default 124)\n");
+  printf("  --lod <r0,r1,...>            generate lods with given triangle ratios to lod0\n");
+  printf("  --lod-error <e>              max lod error relative to mesh extents (default 0.01)\n");
+  printf("  --quantize                   octahedral normal/tangent and half float texcoord\n");
+  printf("  --quantize-position          unorm16 position relative to mesh aabb (with --quantize)\n");
+  printf("  --texcoord-unorm16           unorm16 texcoord instead of half float (with --quantize)\n");
+  printf("  --vertex-layout <layout>     separate(default), position-interleaved or interleaved\n");
+  printf("  --no-index16                 always output uint32 indices\n");
+  printf("  --section-alignment <n>      alignment of binary sections in bytes (default 16)\n");
+  printf("  --group-per-mesh             store index and vertex data of each mesh contiguously\n");
+  printf("  --chunk-size-mb <n>          split binary into files of at most n MiB\n");
+  printf("  --cell-size <s>              partition instances into grid cells of size s, one binary per cell\n");
+  printf("  --compress-textures          bc compress referenced textures with mips to dds files\n");
+  printf("  --orm-bc1                    bc1 instead of bc7 for occlusion-metallic-roughness textures\n");
+  printf("  --bvh                        build a bvh over instance bounds for culling\n");
+  printf("  --streaming                  write meshes straight to file to bound memory (no lods/meshlets)\n");
+  printf("  --json                       also output json dump of the binary for debugging\n");
+  printf("  --metrics-dir <dir>          write stage timings and counters per file as chrome trace json\n");
+  printf("  --cache-dir <dir>            reuse results of unchanged inputs from cache directory\n");
+}
+auto GetStringArg(const int argc, const char* args[], int* index) {
+  if (*index + 1 >= argc) {
+    printf("missing value for %s\n", args[*index]);
+    exit(1);
+  }
+  (*index)++;
+  return args[*index];
+}
+auto GetUint32Arg(const int argc, const char* args[], int* index) {
+  return static_cast<uint32_t>(strtoul(GetStringArg(argc, args, index), nullptr, 10));
+}
+auto ParseVertexLayout(const char* const str) {
+  if (strcmp(str, "position-interleaved") == 0) { return modelconv::VertexLayout::kPositionAndInterleaved; }
+  if (strcmp(str, "interleaved") == 0) { return modelconv::VertexLayout::kInterleaved; }
+  if (strcmp(str, "separate") != 0) {
+    printf("unknown vertex layout %s, using separate\n", str);
+  }
+  return modelconv::VertexLayout::kSeparate;
+}
+auto ParsePostProcessPreset(const char* const str) {
+  if (strcmp(str, "fast") == 0) { return modelconv::PostProcessPreset::kFast; }
+  if (strcmp(str, "thorough") == 0) { return modelconv::PostProcessPreset::kThorough; }
+  if (strcmp(str, "default") != 0) {
+    printf("unknown post-process preset %s, using default\n", str);
+  }
+  return modelconv::PostProcessPreset::kDefault;
+}
+auto ParseFloatList(const char* str) {
+  std::vector<float> list;
+  char* end = nullptr;
+  while (*str != '\0') {
+    const auto val = strtof(str, &end);
+    if (end == str) { break; }
+    list.push_back(val);
+    str = (*end == ',') ? end + 1 : end;
+  }
+  return list;
+}
+} // namespace anonymous
 int main(const int argc, const char* args[]) {
-  if (argc == 3) {
-    modelconv::OutputToDirectory(args[1], args[2]);
+  modelconv::Options options;
+  modelconv::BatchOptions batch_options;
+  bool batch_mode = false;
+  const char* positional_args[2]{};
+  int positional_arg_num = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(args[i], "--", 2) != 0) {
+      if (positional_arg_num >= 2) {
+        printf("too many arguments %s\n", args[i]);
+        return 1;
+      }
+      positional_args[positional_arg_num] = args[i];
+      positional_arg_num++;
+      continue;
+    }
+    if (strcmp(args[i], "--batch") == 0) {
+      batch_mode = true;
+      continue;
+    }
+    if (strcmp(args[i], "--jobs") == 0) {
+      batch_options.thread_num = GetUint32Arg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--scene-jobs") == 0) {
+      options.thread_num = GetUint32Arg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--memory-budget-mb") == 0) {
+      batch_options.memory_budget_in_bytes = static_cast<uint64_t>(GetUint32Arg(argc, args, &i)) * 1024 * 1024;
+      continue;
+    }
+    if (strcmp(args[i], "--post-process") == 0) {
+      options.post_process_preset = ParsePostProcessPreset(GetStringArg(argc, args, &i));
+      continue;
+    }
+    if (strcmp(args[i], "--enable-step") == 0) {
+      options.enabled_post_process_steps.push_back(GetStringArg(argc, args, &i));
+      continue;
+    }
+    if (strcmp(args[i], "--disable-step") == 0) {
+      options.disabled_post_process_steps.push_back(GetStringArg(argc, args, &i));
+      continue;
+    }
+    if (strcmp(args[i], "--no-direct-gltf") == 0) {
+      options.direct_gltf_import = false;
+      continue;
+    }
+    if (strcmp(args[i], "--merge-static") == 0) {
+      options.merge_static_meshes = true;
+      continue;
+    }
+    if (strcmp(args[i], "--batch-max-vertices") == 0) {
+      options.static_batch_max_vertices = GetUint32Arg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--no-optimize") == 0) {
+      options.optimize_mesh = false;
+      continue;
+    }
+    if (strcmp(args[i], "--meshlet") == 0) {
+      options.build_meshlets = true;
+      continue;
+    }
+    if (strcmp(args[i], "--meshlet-max-vertices") == 0) {
+      options.meshlet_max_vertices = GetUint32Arg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--meshlet-max-triangles") == 0) {
+      options.meshlet_max_triangles = GetUint32Arg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--lod") == 0) {
+      options.lod_target_ratios = ParseFloatList(GetStringArg(argc, args, &i));
+      continue;
+    }
+    if (strcmp(args[i], "--lod-error") == 0) {
+      options.lod_target_error = strtof(GetStringArg(argc, args, &i), nullptr);
+      continue;
+    }
+    if (strcmp(args[i], "--quantize") == 0) {
+      options.quantize_vertex = true;
+      continue;
+    }
+    if (strcmp(args[i], "--quantize-position") == 0) {
+      options.quantize_position = true;
+      continue;
+    }
+    if (strcmp(args[i], "--texcoord-unorm16") == 0) {
+      options.texcoord_unorm16 = true;
+      continue;
+    }
+    if (strcmp(args[i], "--vertex-layout") == 0) {
+      options.vertex_layout = ParseVertexLayout(GetStringArg(argc, args, &i));
+      continue;
+    }
+    if (strcmp(args[i], "--no-index16") == 0) {
+      options.narrow_index_buffer = false;
+      continue;
+    }
+    if (strcmp(args[i], "--section-alignment") == 0) {
+      options.section_alignment = GetUint32Arg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--group-per-mesh") == 0) {
+      options.group_streams_per_mesh = true;
+      continue;
+    }
+    if (strcmp(args[i], "--chunk-size-mb") == 0) {
+      options.chunk_size_in_bytes = static_cast<uint64_t>(GetUint32Arg(argc, args, &i)) * 1024 * 1024;
+      continue;
+    }
+    if (strcmp(args[i], "--cell-size") == 0) {
+      options.spatial_cell_size = strtof(GetStringArg(argc, args, &i), nullptr);
+      continue;
+    }
+    if (strcmp(args[i], "--compress-textures") == 0) {
+      options.compress_textures = true;
+      continue;
+    }
+    if (strcmp(args[i], "--orm-bc1") == 0) {
+      options.texture_orm_bc1 = true;
+      continue;
+    }
+    if (strcmp(args[i], "--bvh") == 0) {
+      options.build_bvh = true;
+      continue;
+    }
+    if (strcmp(args[i], "--streaming") == 0) {
+      options.streaming_write = true;
+      continue;
+    }
+    if (strcmp(args[i], "--json") == 0) {
+      options.output_json = true;
+      continue;
+    }
+    if (strcmp(args[i], "--metrics-dir") == 0) {
+      options.metrics_dir = GetStringArg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--cache-dir") == 0) {
+      options.cache_dir = GetStringArg(argc, args, &i);
+      continue;
+    }
+    printf("unknown option %s\n", args[i]);
+    PrintUsage(args[0]);
+    return 1;
+  }
+  if (positional_arg_num != 2) {
+    PrintUsage(args[0]);
+    return 1;
+  }
+  if (batch_mode) {
+    const auto input_filepaths = modelconv::ListInputFiles(positional_args[0]);
+    if (input_filepaths.empty()) {
+      printf("no input files found in %s\n", positional_args[0]);
+      return 1;
+    }
+    return modelconv::BatchOutputToDirectory(input_filepaths, positional_args[1], options, batch_options) == 0 ? 0 : 1;
   }
+  return modelconv::OutputToDirectory(positional_args[0], positional_args[1], options) ? 0 : 1;
 }
@@ -0,0 +1,133 @@
+#include "modelconv/benchmark.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "nlohmann/json.hpp"
+namespace {
+void PrintUsage(const char* const app_name) {
+  printf("usage: %s [options]\n", app_name);
+  printf("  --iterations <n>             conversions per scene, fastest is reported (default 3)\n");
+  printf("  --output-dir <dir>           where converted files are written (default benchmark_output)\n");
+  printf("  --save <file>                save results as json baseline\n");
+  printf("  --baseline <file>            compare against saved results\n");
+  printf("  --tolerance <ratio>          slowdown to baseline reported as regression (default 0.1)\n");
+  printf("  --scene-jobs <n>             worker threads within a scene (default: hardware concurrency)\n");
+  printf("  --quantize                   octahedral normal/tangent and half float texcoord\n");
+}
+auto GetStringArg(const int argc, const char* args[], int* index) {
+  if (*index + 1 >= argc) {
+    printf("missing value for %s\n", args[*index]);
+    exit(1);
+  }
+  (*index)++;
+  return args[*index];
+}
+auto GetUint32Arg(const int argc, const char* args[], int* index) {
+  return static_cast<uint32_t>(strtoul(GetStringArg(argc, args, index), nullptr, 10));
+}
+auto CreateResultJson(const std::vector<modelconv::BenchmarkResult>& results) {
+  auto json = nlohmann::json::array();
+  for (const auto& result : results) {
+    nlohmann::json entry;
+    entry["scene"] = result.scene_name;
+    entry["stage"] = result.stage;
+    entry["elapsed_ms"] = result.elapsed_ms;
+    entry["vertex_num"] = result.vertex_num;
+    entry["bytes_written"] = result.bytes_written;
+    entry["vertices_per_second"] = result.vertices_per_second;
+    entry["megabytes_per_second"] = result.megabytes_per_second;
+    json.push_back(entry);
+  }
+  return json;
+}
+auto FindBaselineMs(const nlohmann::json& baseline, const modelconv::BenchmarkResult& result) {
+  for (const auto& entry : baseline) {
+    if (entry["scene"] == result.scene_name && entry["stage"] == result.stage) {
+      return entry["elapsed_ms"].get<double>();
+    }
+  }
+  return 0.0;
+}
+// returns number of regressions
+auto PrintResults(const std::vector<modelconv::BenchmarkResult>& results, const nlohmann::json& baseline, const double tolerance) {
+  uint32_t regression_num = 0;
+  printf("%-16s %-28s %12s %14s %10s %10s\n", "scene", "stage", "ms", "vertices/s", "MB/s", "baseline");
+  for (const auto& result : results) {
+    printf("%-16s %-28s %12.3f %14.0f %10.1f", result.scene_name.c_str(), result.stage.c_str(), result.elapsed_ms, result.vertices_per_second, result.megabytes_per_second);
+    const auto baseline_ms = FindBaselineMs(baseline, result);
+    if (baseline_ms <= 0.0) {
+      printf("\n");
+      continue;
+    }
+    const auto ratio = result.elapsed_ms / baseline_ms;
+    const auto regressed = ratio > 1.0 + tolerance;
+    printf(" %9.2fx%s\n", ratio, regressed ? " REGRESSION" : "");
+    if (regressed) {
+      regression_num++;
+    }
+  }
+  return regression_num;
+}
+} // namespace anonymous
+int main(const int argc, const char* args[]) {
+  modelconv::Options options;
+  uint32_t iteration_num = 3;
+  const char* output_dir = "benchmark_output";
+  const char* save_filename = nullptr;
+  const char* baseline_filename = nullptr;
+  double tolerance = 0.1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(args[i], "--iterations") == 0) {
+      iteration_num = GetUint32Arg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--output-dir") == 0) {
+      output_dir = GetStringArg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--save") == 0) {
+      save_filename = GetStringArg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--baseline") == 0) {
+      baseline_filename = GetStringArg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--tolerance") == 0) {
+      tolerance = strtod(GetStringArg(argc, args, &i), nullptr);
+      continue;
+    }
+    if (strcmp(args[i], "--scene-jobs") == 0) {
+      options.thread_num = GetUint32Arg(argc, args, &i);
+      continue;
+    }
+    if (strcmp(args[i], "--quantize") == 0) {
+      options.quantize_vertex = true;
+      continue;
+    }
+    printf("unknown option %s\n", args[i]);
+    PrintUsage(args[0]);
+    return 1;
+  }
+  auto baseline = nlohmann::json::array();
+  if (baseline_filename != nullptr) {
+    std::ifstream baseline_file(baseline_filename);
+    if (!baseline_file) {
+      printf("failed to open baseline %s\n", baseline_filename);
+      return 1;
+    }
+    baseline = nlohmann::json::parse(baseline_file);
+  }
+  const auto results = modelconv::RunBenchmark(modelconv::GetDefaultBenchmarkScenes(), output_dir, options, iteration_num);
+  const auto regression_num = PrintResults(results, baseline, tolerance);
+  if (save_filename != nullptr) {
+    std::ofstream save_file(save_filename);
+    save_file << CreateResultJson(results).dump(2) << std::endl;
+  }
+  if (regression_num > 0) {
+    printf("%u regressions\n", regression_num);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef MODELCONV_BENCHMARK_H
+#define MODELCONV_BENCHMARK_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "modelconv/modelconv.h"
+namespace modelconv {
+// procedurally generated, no asset files needed
+struct BenchmarkScene {
+  std::string name;
+  uint32_t mesh_num{16};
+  uint32_t grid_size{63};   // (grid_size + 1)^2 vertices and grid_size^2 * 2 triangles per mesh
+  uint32_t instance_num{1}; // per mesh
+  uint32_t material_num{4};
+};
+struct BenchmarkResult {
+  std::string scene_name;
+  std::string stage; // prefixed with "streaming " for Options::streaming_write
+  double elapsed_ms{0.0}; // fastest of iterations
+  uint64_t vertex_num{0};
+  uint64_t bytes_written{0};
+  double vertices_per_second{0.0};
+  double megabytes_per_second{0.0}; // of output size
+};
+// scales mesh, vertex, instance and material counts independently
+std::vector<BenchmarkScene> GetDefaultBenchmarkScenes();
+// each stage is timed separately within conversions of each scene, "total" is end to end
+std::vector<BenchmarkResult> RunBenchmark(const std::vector<BenchmarkScene>& scenes, const char* const output_dir, const Options& options = {}, const uint32_t iteration_num = 3);
+}
+#endif
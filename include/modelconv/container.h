@@ -0,0 +1,242 @@
+#ifndef MODELCONV_CONTAINER_H
+#define MODELCONV_CONTAINER_H
+#include <cstdint>
+// layout of the .bin file written by modelconv.
+// all structs are plain data in little endian, usable in place from a memory-mapped file.
+// [ContainerHeader][SectionEntry x section_num][section data...]
+// when split into chunks, <name>.1.bin ... <name>.<chunk_num - 1>.bin follow with [section data...] only.
+// when partitioned into spatial cells, <name>.bin only has kCell and material tables, and each cell is a container of its own.
+namespace modelconv {
+constexpr uint32_t kContainerMagic = 0x4256434D; // "MCVB"
+constexpr uint32_t kContainerVersion = 4;
+constexpr uint32_t kInvalidIndex = ~0U;
+enum class SectionType : uint32_t {
+  kTransformOffset,  // uint32 per mesh, offset to kTransformIndex
+  kTransformIndex,   // uint32, index to kTransform per instance
+  kTransform,        // float32 x 16 per matrix
+  kIndex,            // see MeshEntry::index_stride_in_bytes when format is kPerMesh
+  kPosition,
+  kNormal,
+  kTangent,
+  kTexcoord,
+  kInterleaved,      // see VertexAttributeEntry
+  kMeshlet,          // uint32 x 4 (vertex_offset, triangle_offset, vertex_count, triangle_count)
+  kMeshletVertices,  // uint32
+  kMeshletTriangles, // uint8 x 3, padded to 4 bytes per meshlet
+  kMeshletBounds,    // float32 x 12 (center.xyz, radius, cone_apex.xyz, unused, cone_axis.xyz, cone_cutoff)
+  kMesh,             // MeshEntry
+  kLod,              // LodEntry
+  kMaterial,         // MaterialEntry
+  kTexture,          // TextureEntry
+  kSampler,          // SamplerEntry
+  kString,           // char, not null terminated
+  kVertexAttribute,  // VertexAttributeEntry
+  kMeshBounds,       // MeshBoundsEntry per mesh
+  kInstanceBounds,   // InstanceBoundsEntry per kTransformIndex entry
+  kBvhNode,          // BvhNodeEntry, root first. empty unless built
+  kBvhInstance,      // uint32, index to kInstanceBounds
+  kCell,             // CellEntry, only in the index of a spatially partitioned scene
+  kNum,
+};
+enum class ComponentFormat : uint32_t {
+  kUnknown,
+  kFloat32,
+  kFloat16,
+  kUint32,
+  kUint16,
+  kUint8,
+  kUnorm16,
+  kSnorm16,
+  kPerMesh,     // index format differs per mesh
+  kInterleaved, // multiple attributes
+  kStruct,      // table of entries defined in this header
+};
+enum class AttributeEncoding : uint32_t {
+  kNone,
+  kOctahedral,
+  kOctahedralWithSignBit, // lsb of y is set for negative bitangent sign
+};
+struct ContainerHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t section_num;
+  uint32_t header_size_in_bytes; // sizeof(ContainerHeader)
+  uint64_t section_table_offset_in_bytes;
+  uint64_t file_size_in_bytes; // of this file (chunk 0)
+  uint32_t section_alignment; // of sections not grouped per mesh and of the first section of each mesh
+  uint32_t chunk_num; // 1 unless split into chunks
+};
+struct SectionEntry {
+  SectionType type;
+  ComponentFormat format;
+  uint32_t component_num;
+  uint32_t stride_in_bytes; // 0 for kPerMesh
+  uint64_t offset_in_bytes; // from the beginning of the chunk file
+  uint64_t size_in_bytes;
+  AttributeEncoding encoding;
+  uint32_t attribute_offset; // to kVertexAttribute, for kInterleaved
+  uint32_t attribute_num;
+  uint32_t padding_in_bytes; // between the previous section and this one
+  uint32_t mesh_index; // kInvalidIndex unless streams are grouped per mesh
+  uint32_t chunk_index; // file containing the section data, 0 for this file
+};
+struct VertexAttributeEntry {
+  SectionType semantic; // kPosition, kNormal, kTangent or kTexcoord
+  ComponentFormat format;
+  uint32_t component_num;
+  uint32_t offset_in_bytes; // in stride
+  AttributeEncoding encoding;
+};
+struct MeshEntry {
+  uint32_t index_stride_in_bytes;
+  uint32_t index_buffer_len; // lod0
+  uint64_t index_buffer_offset_in_bytes; // lod0, from the beginning of kIndex (of this mesh when grouped)
+  uint32_t vertex_buffer_index_offset; // 0 when grouped
+  uint32_t vertex_num;
+  uint32_t material_index; // kInvalidIndex if the material could not be loaded
+  uint32_t instance_num;
+  uint32_t meshlet_offset;
+  uint32_t meshlet_num;
+  uint32_t lod_offset; // to kLod, lod0 included
+  uint32_t lod_num;
+  // dequantized = quantized * scale + offset
+  float position_offset[3];
+  float position_scale[3];
+  float texcoord_offset[2];
+  float texcoord_scale[2];
+  // file range of this mesh's index and vertex sections when streams are grouped per mesh, otherwise 0
+  // the range is in a single chunk, see SectionEntry::chunk_index of the sections
+  uint64_t data_offset_in_bytes;
+  uint64_t data_size_in_bytes;
+};
+struct LodEntry {
+  uint64_t index_buffer_offset_in_bytes; // from the beginning of kIndex
+  uint32_t index_buffer_len;
+  float error; // object space
+};
+// object space of the mesh, before quantization
+struct MeshBoundsEntry {
+  float aabb_min[3];
+  float aabb_max[3];
+  float sphere_center[3];
+  float sphere_radius;
+};
+// world space
+struct InstanceBoundsEntry {
+  float aabb_min[3];
+  uint32_t mesh_index;
+  float aabb_max[3];
+  uint32_t transform_index; // to kTransform
+};
+// depth first, the first child of an interior node is at node index + 1
+struct BvhNodeEntry {
+  float aabb_min[3];
+  uint32_t offset; // second child for interior nodes, first kBvhInstance entry for leaves
+  float aabb_max[3];
+  uint32_t instance_num; // 0 for interior nodes
+};
+// a cell container has the meshes and transforms of instances whose world bounds center is in the cell.
+// meshes instanced across cells are stored in each of them. material indices are the same in all cells and the index.
+struct CellEntry {
+  int32_t coord[3];     // floor(bounds center / cell size)
+  uint32_t path_offset; // to kString, file name of the cell container relative to the index
+  float aabb_min[3];    // world space bounds of the instances in the cell, may exceed the cell
+  uint32_t path_len;
+  float aabb_max[3];
+  uint32_t instance_num;
+  uint64_t file_size_in_bytes; // of the cell container (chunk 0)
+  uint32_t mesh_num;
+  uint32_t chunk_num;
+};
+enum class TextureType : uint32_t {
+  kAlbedo,
+  kOcclusionMetallicRoughness, // occlusion(R), roughness(G), metallic(B) as in gltf
+  kNormal,
+  kEmissive,
+};
+enum class TextureAddressMode : uint32_t {
+  kUnset,
+  kWrap,
+  kClamp,
+  kMirror,
+};
+enum class TextureFilter : uint32_t {
+  kPoint,
+  kLinear,
+};
+enum class AlphaMode : uint32_t {
+  kOpaque,
+  kMask,
+  kBlend,
+};
+struct TextureRef {
+  uint32_t texture_index;
+  uint32_t sampler_index;
+};
+struct MaterialEntry {
+  TextureRef albedo_texture;
+  float albedo_factor[4];
+  TextureRef occlusion_metallic_roughness_texture;
+  float occlusion_strength;
+  float metallic_factor;
+  float roughness_factor;
+  TextureRef normal_texture;
+  float normal_scale;
+  TextureRef emissive_texture;
+  float emissive_factor[4];
+  uint32_t double_sided;
+  AlphaMode alpha_mode;
+  float alpha_cutoff;
+  uint32_t reserved;
+};
+struct TextureEntry {
+  TextureType type;
+  uint32_t path_offset; // to kString
+  uint32_t path_len;
+  uint32_t reserved;
+};
+struct SamplerEntry {
+  TextureAddressMode address_mode[3]; // u, v, w
+  TextureFilter mag_filter;
+  TextureFilter min_filter;
+  TextureFilter mip_filter;
+};
+static_assert(sizeof(ContainerHeader) == 40);
+static_assert(sizeof(SectionEntry) == 56);
+static_assert(sizeof(VertexAttributeEntry) == 20);
+static_assert(sizeof(MeshEntry) == 104);
+static_assert(sizeof(LodEntry) == 16);
+static_assert(sizeof(MeshBoundsEntry) == 40);
+static_assert(sizeof(InstanceBoundsEntry) == 32);
+static_assert(sizeof(BvhNodeEntry) == 32);
+static_assert(sizeof(CellEntry) == 64);
+static_assert(sizeof(MaterialEntry) == 96);
+static_assert(sizeof(TextureEntry) == 16);
+static_assert(sizeof(SamplerEntry) == 24);
+inline const ContainerHeader* GetContainerHeader(const void* const file) {
+  const auto header = static_cast<const ContainerHeader*>(file);
+  if (header->magic != kContainerMagic || header->version != kContainerVersion) { return nullptr; }
+  return header;
+}
+inline const SectionEntry* GetSectionTable(const void* const file) {
+  const auto header = GetContainerHeader(file);
+  if (header == nullptr) { return nullptr; }
+  return reinterpret_cast<const SectionEntry*>(static_cast<const uint8_t*>(file) + header->section_table_offset_in_bytes);
+}
+// first one for sections grouped per mesh
+inline const SectionEntry* FindSection(const void* const file, const SectionType type) {
+  const auto header = GetContainerHeader(file);
+  if (header == nullptr) { return nullptr; }
+  const auto sections = GetSectionTable(file);
+  for (uint32_t i = 0; i < header->section_num; i++) {
+    if (sections[i].type == type) { return &sections[i]; }
+  }
+  return nullptr;
+}
+// chunk is the file of section.chunk_index
+template <typename T>
+const T* GetSectionData(const void* const chunk, const SectionEntry& section) {
+  return reinterpret_cast<const T*>(static_cast<const uint8_t*>(chunk) + section.offset_in_bytes);
+}
+} // namespace modelconv
+#endif
@@ -1,7 +1,106 @@
 #ifndef MINIMAL_CPP_PJ_H
 #define MINIMAL_CPP_PJ_H
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include "modelconv/container.h"
 namespace modelconv {
-void OutputToDirectory(const char* const input_filepath, const char* const output_dir);
+enum class VertexLayout : uint8_t {
+  kSeparate,               // one stream per attribute
+  kPositionAndInterleaved, // position stream + interleaved normal/tangent/texcoord stream
+  kInterleaved,            // single interleaved stream
+};
+enum class PostProcessPreset : uint8_t {
+  kFast,     // only steps the converter depends on, for clean exports such as glTF
+  kDefault,  // also joins identical vertices, finds instances and fixes invalid data
+  kThorough, // also removes degenerate triangles and merges small meshes
+};
+struct Options {
+  PostProcessPreset post_process_preset{PostProcessPreset::kDefault};
+  std::vector<std::string> enabled_post_process_steps;  // assimp step names added to the preset, e.g. "JoinIdenticalVertices"
+  std::vector<std::string> disabled_post_process_steps; // assimp step names removed from the preset
+  bool direct_gltf_import{true}; // read .gltf/.glb accessors from mapped buffers without assimp with the fast or default preset. thorough or extra steps, and content it cannot handle (e.g. missing tangents), fall back to assimp.
+  bool merge_static_meshes{false};            // bake transforms of meshes drawn once and merge them per material, instanced meshes are kept
+  uint32_t static_batch_max_vertices{0xFFFF}; // vertices per merged mesh, meshes exceeding it are baked alone
+  bool optimize_mesh{true}; // vertex cache, overdraw and vertex fetch optimization per mesh
+  bool build_meshlets{false};
+  uint32_t meshlet_max_vertices{64};   // <= 255
+  uint32_t meshlet_max_triangles{124}; // <= 512, multiple of 4
+  std::vector<float> lod_target_ratios; // triangle count ratio to lod0 per lod level, e.g. {0.5f, 0.25f}. empty for no lod.
+  float lod_target_error{0.01f};        // relative to mesh extents
+  bool quantize_vertex{false};   // octahedral snorm16 normal/tangent, half texcoord
+  bool quantize_position{false}; // unorm16 position relative to mesh aabb, requires quantize_vertex
+  bool texcoord_unorm16{false};  // unorm16 texcoord relative to mesh uv range instead of half, requires quantize_vertex
+  VertexLayout vertex_layout{VertexLayout::kSeparate};
+  bool narrow_index_buffer{true}; // uint16 indices for meshes with vertex_num <= 0xFFFF
+  uint32_t section_alignment{16}; // power of two >= 16, e.g. 256 or 4096 for direct upload from mapped file
+  bool group_streams_per_mesh{false}; // index and vertex data of each mesh in a contiguous range of the file
+  uint64_t chunk_size_in_bytes{0};    // split the .bin into <name>.bin, <name>.1.bin, ... of at most this size (unless a section or mesh is larger). 0 for a single file.
+  float spatial_cell_size{0.0f};      // partition instances into a grid of cells of this size, one <name>.cell_x_y_z.bin per cell indexed by <name>.bin. 0 to disable.
+  bool build_bvh{false};              // sah bvh over world space instance bounds. mesh and instance bounds are always written.
+  bool compress_textures{false}; // bc7 albedo/emissive/orm, bc5 normal with mips to textures/*.dds, replacing paths in material settings
+  bool texture_orm_bc1{false};   // bc1 instead of bc7 for occlusion-metallic-roughness, requires compress_textures
+  bool streaming_write{false};    // write each mesh to its final file offset instead of gathering whole scene buffers. lods and meshlets are not generated.
+  bool output_json{false};        // human readable dump of the binary container contents for debugging
+  uint32_t thread_num{0};         // threads used within a scene, 0 for hardware concurrency. output does not depend on it.
+  std::string metrics_dir;        // chrome trace json with stage timings and counters per converted file (not for cache hits). empty to disable.
+  std::string cache_dir;          // conversion results are reused from here if input, referenced files and options are unchanged. empty to disable.
+};
+struct BatchOptions {
+  uint32_t thread_num{0};             // 0 for hardware concurrency
+  uint64_t memory_budget_in_bytes{0}; // bound for estimated memory of scenes converted at the same time. 0 for unlimited.
+};
+bool OutputToDirectory(const char* const input_filepath, const char* const output_dir, const Options& options = {});
+// list file (one path per line), directory (searched recursively for supported formats) or glob pattern in file name (e.g. "dir/*.gltf")
+std::vector<std::string> ListInputFiles(const char* const list_file_or_glob);
+// returns number of failed files
+uint32_t BatchOutputToDirectory(const std::vector<std::string>& input_filepaths, const char* const output_dir, const Options& options = {}, const BatchOptions& batch_options = {});
+// container with the layout of the .bin file (see container.h) and material settings json held in memory.
+// move only, sections are viewed in place and never copied.
+class ConversionResult {
+ public:
+  ConversionResult() = default;
+  ConversionResult(std::vector<uint8_t>&& container, std::string&& material_settings_json)
+      : container_(std::move(container)), material_settings_json_(std::move(material_settings_json)) {}
+  ConversionResult(ConversionResult&&) noexcept = default;
+  ConversionResult& operator=(ConversionResult&&) noexcept = default;
+  ConversionResult(const ConversionResult&) = delete;
+  ConversionResult& operator=(const ConversionResult&) = delete;
+  explicit operator bool() const { return !container_.empty(); }
+  std::span<const uint8_t> GetContainer() const { return container_; }
+  const std::string& GetMaterialSettingsJson() const { return material_settings_json_; }
+  std::span<const SectionEntry> GetSections() const {
+    if (container_.empty()) { return {}; }
+    return {GetSectionTable(container_.data()), GetContainerHeader(container_.data())->section_num};
+  }
+  // first one for sections grouped per mesh, nullptr if not found
+  const SectionEntry* FindSection(const SectionType type) const {
+    if (container_.empty()) { return nullptr; }
+    return modelconv::FindSection(container_.data(), type);
+  }
+  template <typename T>
+  std::span<const T> GetSectionData(const SectionEntry& section) const {
+    return {modelconv::GetSectionData<T>(container_.data(), section), section.size_in_bytes / sizeof(T)};
+  }
+  template <typename T>
+  std::span<const T> GetSectionData(const SectionType type) const {
+    const auto section = FindSection(type);
+    if (section == nullptr) { return {}; }
+    return GetSectionData<T>(*section);
+  }
+ private:
+  std::vector<uint8_t> container_; // data() is aligned to __STDCPP_DEFAULT_NEW_ALIGNMENT__, not to section_alignment
+  std::string material_settings_json_;
+};
+// converts without touching disk, empty result on failure.
+// texture paths in the material settings refer to source images and are neither packed nor compressed.
+// streaming_write, chunk_size_in_bytes, spatial_cell_size, output_json, metrics_dir and cache_dir are ignored.
+ConversionResult ConvertToMemory(const char* const input_filepath, const Options& options = {});
+// format_hint is the file extension without dot, e.g. "glb" or "fbx".
+// external files (e.g. .bin buffers of .gltf) cannot be resolved, use self-contained formats.
+ConversionResult ConvertToMemory(const void* const data, const std::size_t size_in_bytes, const char* const format_hint, const Options& options = {});
 }
 #endif
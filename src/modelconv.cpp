@@ -1,16 +1,56 @@
 #include "modelconv/modelconv.h"
+#include "modelconv/container.h"
+#include "modelconv/benchmark.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
 #include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "assimp/Importer.hpp"
 #include "assimp/GltfMaterial.h"
 #include "assimp/postprocess.h"
 #include "assimp/scene.h"
+#include "bc7enc.h"
+#include "meshoptimizer.h"
+#define RGBCX_IMPLEMENTATION
+#include "rgbcx.h"
 #include "spdlog/spdlog.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-macros"
@@ -27,7 +67,12 @@
 namespace modelconv {
 namespace {
 using namespace Assimp;
-const uint32_t kInvalidIndex = ~0U;
+struct LodIndexRange {
+  uint32_t index_buffer_offset{0};
+  uint32_t index_buffer_len{0};
+  uint64_t index_buffer_offset_in_bytes{0}; // in output binary
+  float error{0.0f}; // in model space
+};
 struct PerDrawCallModelIndexSet {
   std::vector<uint32_t> transform_matrix_index_list;
   uint32_t index_buffer_offset{0};
@@ -35,15 +80,33 @@ struct PerDrawCallModelIndexSet {
   uint32_t vertex_buffer_index_offset{0};
   uint32_t vertex_num{0};
   uint32_t material_index{0};
+  uint32_t index_stride_in_bytes{sizeof(uint32_t)}; // in output binary
+  uint64_t index_buffer_offset_in_bytes{0};         // in output binary
+  uint32_t meshlet_offset{0};
+  uint32_t meshlet_num{0};
+  std::vector<LodIndexRange> lods; // excluding lod0 (index_buffer_offset, index_buffer_len)
+  // dequantized = quantized * scale + offset
+  float position_offset[3]{0.0f, 0.0f, 0.0f};
+  float position_scale[3]{1.0f, 1.0f, 1.0f};
+  float texcoord_offset[2]{0.0f, 0.0f};
+  float texcoord_scale[2]{1.0f, 1.0f};
 };
+// element counts and offsets, see IsWithinElementRange. byte offsets and sizes are 64-bit.
 auto GetUint32(const std::size_t s) {
+  assert(s <= std::numeric_limits<uint32_t>::max());
+  if (s > std::numeric_limits<uint32_t>::max()) {
+    logerror("element num {} exceeds {}, output offsets are corrupt", s, std::numeric_limits<uint32_t>::max());
+  }
   return static_cast<uint32_t>(s);
 }
+// aiVector3D and aiMatrix4x4 are copied as float arrays in bulk
+static_assert(sizeof(aiVector3D) == sizeof(float) * 3);
+static_assert(sizeof(aiMatrix4x4) == sizeof(float) * 16);
 void PushTransformMatrix(const aiNode* node,
                          const uint32_t parent_transform_index,
                          const aiMatrix4x4& parent_transform,
                          PerDrawCallModelIndexSet* per_draw_call_model_index_set,
-                         std::vector<aiMatrix4x4>* transform_matrix_list) {
+                         std::vector<float>* transform_matrix_list) {
   auto transform_index = parent_transform_index;
   auto transform = parent_transform;
   if (!node->mTransformation.IsIdentity()) {
@@ -52,8 +115,9 @@ void PushTransformMatrix(const aiNode* node,
   }
   if (node->mNumMeshes > 0) {
     if (transform_index == kInvalidIndex) {
-      transform_index = GetUint32((*transform_matrix_list).size());
-      (*transform_matrix_list).push_back(transform);
+      const uint32_t kComponentNum = 16;
+      transform_index = GetUint32(transform_matrix_list->size() / kComponentNum);
+      transform_matrix_list->insert(transform_matrix_list->end(), &transform.a1, &transform.a1 + kComponentNum);
     }
     for (uint32_t i = 0; i < node->mNumMeshes; i++) {
       per_draw_call_model_index_set[node->mMeshes[i]].transform_matrix_index_list.push_back(transform_index);
@@ -63,11 +127,9 @@ void PushTransformMatrix(const aiNode* node,
     PushTransformMatrix(node->mChildren[i], transform_index, transform, per_draw_call_model_index_set, transform_matrix_list);
   }
 }
-auto Push2Components(const aiVector3D& vertex, std::vector<float>* list) {
-  list->insert(list->end(), {vertex.x, vertex.y});
-}
-auto Push3Components(const aiVector3D& vertex, std::vector<float>* list) {
-  list->insert(list->end(), {vertex.x, vertex.y, vertex.z});
+auto Copy2Components(const aiVector3D& vertex, float* dst) {
+  dst[0] = vertex.x;
+  dst[1] = vertex.y;
 }
 struct MeshBuffers {
   std::vector<uint32_t> index_buffer;
@@ -75,621 +137,4189 @@ struct MeshBuffers {
   std::vector<float> vertex_buffer_normal;
   std::vector<float> vertex_buffer_tangent;
   std::vector<float> vertex_buffer_texcoord;
+  std::vector<int8_t> vertex_buffer_tangent_sign; // bitangent handedness (+1 or -1), only used for quantized tangent
 };
-auto GatherMeshData(const uint32_t mesh_num, const aiMesh* const * meshes,
-                    std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
-  std::vector<uint32_t> index_buffer;
-  std::vector<float> vertex_buffer_position;
-  std::vector<float> vertex_buffer_normal;
-  std::vector<float> vertex_buffer_tangent;
-  std::vector<float> vertex_buffer_texcoord;
-  uint32_t vertex_buffer_index_offset = 0;
-  for (uint32_t i = 0; i < mesh_num; i++) {
-    auto mesh = meshes[i];
-    if (!mesh->HasFaces()) { continue; }
-    if ((mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) == 0) {
-      logwarn("invalid primitive type {}", mesh->mPrimitiveTypes);
-      continue;
+auto GetTangentSign(const aiVector3D& normal, const aiVector3D& tangent, const aiVector3D& bitangent) {
+  const auto cross = normal ^ tangent;
+  return static_cast<int8_t>((cross * bitangent) < 0.0f ? -1 : 1);
+}
+auto GetThreadNum(const uint32_t thread_num) {
+  return thread_num != 0 ? thread_num : std::max(std::thread::hardware_concurrency(), 1U);
+}
+template <typename F>
+void ParallelFor(const uint32_t thread_num, const uint32_t count, F&& func) {
+  const auto worker_num = std::min(GetThreadNum(thread_num), count);
+  if (worker_num <= 1) {
+    for (uint32_t i = 0; i < count; i++) {
+      func(i);
     }
-    auto& per_mesh_data = (*per_draw_call_model_index_set)[i];
-    {
-      // per mesh index data
-      const uint32_t kTriangleVertexNum = 3;
-      per_mesh_data.index_buffer_offset = static_cast<uint32_t>(index_buffer.size());
-      per_mesh_data.index_buffer_len    = mesh->mNumFaces * kTriangleVertexNum;
-      // index buffer
-      index_buffer.reserve(per_mesh_data.index_buffer_offset + per_mesh_data.index_buffer_len);
-      for (uint32_t j = 0; j < mesh->mNumFaces; j++) {
-        const auto& face = mesh->mFaces[j];
-        if (face.mNumIndices != kTriangleVertexNum) {
-          logerror("invalid face num", face.mNumIndices);
-          continue;
-        }
-        for (uint32_t k = 0; k < kTriangleVertexNum; k++) {
-          index_buffer.push_back(face.mIndices[k]);
-        }
-      }
-      assert(index_buffer.size() == per_mesh_data.index_buffer_offset + per_mesh_data.index_buffer_len);
+    return;
+  }
+  std::atomic<uint32_t> next_index{0};
+  const auto process = [&]() {
+    for (auto i = next_index.fetch_add(1); i < count; i = next_index.fetch_add(1)) {
+      func(i);
     }
-    {
-      // per mesh vertex buffer data
-      per_mesh_data.vertex_buffer_index_offset = vertex_buffer_index_offset;
-      per_mesh_data.vertex_num = mesh->mNumVertices;
-      vertex_buffer_index_offset += mesh->mNumVertices;
-      vertex_buffer_position.reserve((per_mesh_data.vertex_buffer_index_offset + mesh->mNumVertices) * 3);
-      vertex_buffer_normal.reserve((per_mesh_data.vertex_buffer_index_offset + mesh->mNumVertices) * 3);
-      vertex_buffer_tangent.reserve((per_mesh_data.vertex_buffer_index_offset + mesh->mNumVertices) * 3);
-      vertex_buffer_texcoord.reserve((per_mesh_data.vertex_buffer_index_offset + mesh->mNumVertices) * 2);
-      const auto valid_texcoord = (mesh->HasTextureCoords(0) && mesh->mNumUVComponents[0] == 2);
-      if (!valid_texcoord) {
-        logerror("invalid texcoord existance:{} component num:{}", mesh->HasTextureCoords(0), mesh->mNumUVComponents[0]);
-      }
-      for (uint32_t j = 0; j < mesh->mNumVertices; j++) {
-        Push3Components(mesh->mVertices[j],   &vertex_buffer_position);
-        Push3Components(mesh->mNormals[j],    &vertex_buffer_normal);
-        Push3Components(mesh->mTangents[j],   &vertex_buffer_tangent);
-        if (valid_texcoord) {
-          Push2Components(mesh->mTextureCoords[0][j], &vertex_buffer_texcoord);
-        }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(worker_num - 1);
+  for (uint32_t i = 1; i < worker_num; i++) {
+    threads.emplace_back(process);
+  }
+  process();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+auto GetElapsedMs(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+struct StageTiming {
+  std::string name;
+  double start_ms{0.0}; // from ConversionMetrics::start
+  double elapsed_ms{0.0};
+};
+// per input file, see CreateTraceJson
+struct ConversionMetrics {
+  std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+  std::vector<StageTiming> stages;
+  uint64_t mesh_num{0};
+  uint64_t vertex_num{0};
+  uint64_t triangle_num{0};
+  uint64_t bytes_written{0};
+  uint64_t peak_rss_in_bytes{0}; // of the whole process, i.e. including other files converted in parallel
+};
+void RecordStage(const char* const name, const std::chrono::steady_clock::time_point& start, ConversionMetrics* metrics) {
+  metrics->stages.push_back(StageTiming{
+      .name = name,
+      .start_ms = std::chrono::duration<double, std::milli>(start - metrics->start).count(),
+      .elapsed_ms = GetElapsedMs(start),
+    });
+}
+template <typename F>
+auto MeasureStage(const char* const name, ConversionMetrics* metrics, F&& func) {
+  const auto start = std::chrono::steady_clock::now();
+  if constexpr (std::is_void_v<std::invoke_result_t<F>>) {
+    func();
+    RecordStage(name, start, metrics);
+  } else {
+    auto result = func();
+    RecordStage(name, start, metrics);
+    return result;
+  }
+}
+auto GetPeakRssInBytes() -> uint64_t {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters{};
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+  return counters.PeakWorkingSetSize;
+#else
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#if defined(__APPLE__)
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // in kilobytes on linux
+#endif
+#endif
+}
+void LogMetrics(const char* const input_filepath, const ConversionMetrics& metrics) {
+  std::string str;
+  for (const auto& stage : metrics.stages) {
+    str += fmt::format(" {}:{:.2f}ms", stage.name, stage.elapsed_ms);
+  }
+  loginfo("timings {}{}", input_filepath, str);
+  loginfo("metrics {} meshes:{} vertices:{} triangles:{} written:{}bytes peak rss:{}MB", input_filepath, metrics.mesh_num, metrics.vertex_num, metrics.triangle_num, metrics.bytes_written, metrics.peak_rss_in_bytes / (1024 * 1024));
+}
+auto IsValidMesh(const aiMesh& mesh) {
+  if (!mesh.HasFaces()) { return false; }
+  if ((mesh.mPrimitiveTypes & aiPrimitiveType_TRIANGLE) == 0) {
+    logwarn("invalid primitive type {}", mesh.mPrimitiveTypes);
+    return false;
+  }
+  if (!mesh.HasNormals() || !mesh.HasTangentsAndBitangents()) {
+    // e.g. GenSmoothNormals or CalcTangentSpace disabled, or no texcoord to compute tangents from
+    logwarn("mesh without normals or tangents {}", mesh.mName.C_Str());
+    return false;
+  }
+  return true;
+}
+void FillMeshData(const aiMesh& mesh, const PerDrawCallModelIndexSet& per_mesh_data, MeshBuffers* mesh_buffers) {
+  {
+    // per mesh index data
+    const uint32_t kTriangleVertexNum = 3;
+    auto indices = mesh_buffers->index_buffer.data() + per_mesh_data.index_buffer_offset;
+    for (uint32_t j = 0; j < mesh.mNumFaces; j++) {
+      const auto& face = mesh.mFaces[j];
+      if (face.mNumIndices != kTriangleVertexNum) {
+        // left as a degenerate triangle
+        logerror("invalid face num", face.mNumIndices);
+        continue;
+      }
+      for (uint32_t k = 0; k < kTriangleVertexNum; k++) {
+        indices[j * kTriangleVertexNum + k] = face.mIndices[k];
       }
-      assert(vertex_buffer_position.size() == (per_mesh_data.vertex_buffer_index_offset + mesh->mNumVertices) * 3);
-      assert(vertex_buffer_normal.size() == (per_mesh_data.vertex_buffer_index_offset + mesh->mNumVertices) * 3);
-      assert(vertex_buffer_tangent.size() == (per_mesh_data.vertex_buffer_index_offset + mesh->mNumVertices) * 3);
-      assert(vertex_buffer_texcoord.size() == (per_mesh_data.vertex_buffer_index_offset + mesh->mNumVertices) * 2);
     }
-    {
-      // per mesh material
-      per_mesh_data.material_index = mesh->mMaterialIndex;
+  }
+  {
+    // per mesh vertex buffer data
+    const auto vertex_offset = per_mesh_data.vertex_buffer_index_offset;
+    auto position = mesh_buffers->vertex_buffer_position.data() + vertex_offset * 3;
+    auto normal = mesh_buffers->vertex_buffer_normal.data() + vertex_offset * 3;
+    auto tangent = mesh_buffers->vertex_buffer_tangent.data() + vertex_offset * 3;
+    auto texcoord = mesh_buffers->vertex_buffer_texcoord.data() + vertex_offset * 2;
+    auto tangent_sign = mesh_buffers->vertex_buffer_tangent_sign.data() + vertex_offset;
+    const auto valid_texcoord = (mesh.HasTextureCoords(0) && mesh.mNumUVComponents[0] == 2);
+    if (!valid_texcoord) {
+      // left as zero to keep vertex streams of other meshes aligned
+      logerror("invalid texcoord existance:{} component num:{}", mesh.HasTextureCoords(0), mesh.mNumUVComponents[0]);
     }
+    memcpy(position, mesh.mVertices, mesh.mNumVertices * sizeof(aiVector3D));
+    memcpy(normal, mesh.mNormals, mesh.mNumVertices * sizeof(aiVector3D));
+    memcpy(tangent, mesh.mTangents, mesh.mNumVertices * sizeof(aiVector3D));
+    for (uint32_t j = 0; j < mesh.mNumVertices; j++) {
+      tangent_sign[j] = mesh.mBitangents == nullptr ? 1 : GetTangentSign(mesh.mNormals[j], mesh.mTangents[j], mesh.mBitangents[j]);
+      if (valid_texcoord) {
+        Copy2Components(mesh.mTextureCoords[0][j], &texcoord[j * 2]);
+      }
+    }
+  }
+}
+auto AssignMeshOffsets(const uint32_t mesh_num, const aiMesh* const * meshes, std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
+  const uint32_t kTriangleVertexNum = 3;
+  uint32_t index_buffer_len = 0;
+  uint32_t vertex_buffer_index_offset = 0;
+  for (uint32_t i = 0; i < mesh_num; i++) {
+    const auto& mesh = *meshes[i];
+    if (!IsValidMesh(mesh)) { continue; }
+    auto& per_mesh_data = (*per_draw_call_model_index_set)[i];
+    per_mesh_data.index_buffer_offset = index_buffer_len;
+    per_mesh_data.index_buffer_len    = mesh.mNumFaces * kTriangleVertexNum;
+    per_mesh_data.vertex_buffer_index_offset = vertex_buffer_index_offset;
+    per_mesh_data.vertex_num = mesh.mNumVertices;
+    index_buffer_len += per_mesh_data.index_buffer_len;
+    vertex_buffer_index_offset += mesh.mNumVertices;
+  }
+  return std::make_pair(index_buffer_len, vertex_buffer_index_offset);
+}
+void ResizeMeshBuffers(const uint32_t index_buffer_len, const uint32_t vertex_num, MeshBuffers* mesh_buffers) {
+  mesh_buffers->index_buffer.resize(index_buffer_len);
+  mesh_buffers->vertex_buffer_position.resize(vertex_num * 3);
+  mesh_buffers->vertex_buffer_normal.resize(vertex_num * 3);
+  mesh_buffers->vertex_buffer_tangent.resize(vertex_num * 3);
+  mesh_buffers->vertex_buffer_texcoord.resize(vertex_num * 2);
+  mesh_buffers->vertex_buffer_tangent_sign.resize(vertex_num);
+}
+auto GatherMeshData(const uint32_t thread_num, const uint32_t mesh_num, const aiMesh* const * meshes,
+                    std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
+  // offsets are computed serially first so that meshes can be filled in parallel into pre-sized buffers
+  const auto [index_buffer_len, vertex_num] = AssignMeshOffsets(mesh_num, meshes, per_draw_call_model_index_set);
+  MeshBuffers mesh_buffers;
+  ResizeMeshBuffers(index_buffer_len, vertex_num, &mesh_buffers);
+  ParallelFor(thread_num, mesh_num, [&](const uint32_t i) {
+    if ((*per_draw_call_model_index_set)[i].index_buffer_len == 0) { return; }
+    FillMeshData(*meshes[i], (*per_draw_call_model_index_set)[i], &mesh_buffers);
+  });
+  return mesh_buffers;
+}
+template <typename T>
+void RemapVertexStream(const PerDrawCallModelIndexSet& mesh, const uint32_t component_num, const std::vector<uint32_t>& remap, const uint32_t unique_vertex_num, std::vector<T>* buffer) {
+  if (buffer->size() < (mesh.vertex_buffer_index_offset + mesh.vertex_num) * component_num) { return; }
+  auto head = buffer->data() + mesh.vertex_buffer_index_offset * component_num;
+  // in-place remap is supported with a temporary copy of this mesh's range only
+  meshopt_remapVertexBuffer(head, head, mesh.vertex_num, sizeof(T) * component_num, remap.data());
+  // slots after the referenced vertices are not written by the remap and would keep stale vertices.
+  // they are filled with the first vertex, which keeps quantization ranges of the mesh unchanged.
+  for (uint32_t i = unique_vertex_num; i < mesh.vertex_num; i++) {
+    std::copy_n(head, component_num, head + i * component_num);
+  }
+}
+void OptimizeMesh(const PerDrawCallModelIndexSet& mesh, MeshBuffers* mesh_buffers) {
+  if (mesh.index_buffer_len == 0 || mesh.vertex_num == 0) { return; }
+  const float kOverdrawThreshold = 1.05f;
+  auto indices = mesh_buffers->index_buffer.data() + mesh.index_buffer_offset;
+  const auto positions = mesh_buffers->vertex_buffer_position.data() + mesh.vertex_buffer_index_offset * 3;
+  // meshoptimizer functions below support in-place optimization
+  meshopt_optimizeVertexCache(indices, indices, mesh.index_buffer_len, mesh.vertex_num);
+  meshopt_optimizeOverdraw(indices, indices, mesh.index_buffer_len, positions, mesh.vertex_num, sizeof(float) * 3, kOverdrawThreshold);
+  // referenced vertices are reordered by first use to the start of the mesh's vertex range.
+  // unreferenced ones are dropped (remapped to ~0u) and vertex_num is kept, see RemapVertexStream for the remaining slots.
+  std::vector<uint32_t> remap(mesh.vertex_num);
+  const auto unique_vertex_num = GetUint32(meshopt_optimizeVertexFetchRemap(remap.data(), indices, mesh.index_buffer_len, mesh.vertex_num));
+  meshopt_remapIndexBuffer(indices, indices, mesh.index_buffer_len, remap.data());
+  RemapVertexStream(mesh, 3, remap, unique_vertex_num, &mesh_buffers->vertex_buffer_position);
+  RemapVertexStream(mesh, 3, remap, unique_vertex_num, &mesh_buffers->vertex_buffer_normal);
+  RemapVertexStream(mesh, 3, remap, unique_vertex_num, &mesh_buffers->vertex_buffer_tangent);
+  RemapVertexStream(mesh, 2, remap, unique_vertex_num, &mesh_buffers->vertex_buffer_texcoord);
+  RemapVertexStream(mesh, 1, remap, unique_vertex_num, &mesh_buffers->vertex_buffer_tangent_sign);
+}
+struct VertexCacheStatistics {
+  float acmr{0.0f}; // average cache miss ratio, transformed vertices per triangle
+  float atvr{0.0f}; // average transformed vertex ratio, transformed vertices per vertex
+};
+auto AnalyzeVertexCache(const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set, const MeshBuffers& mesh_buffers) {
+  const uint32_t kVertexCacheSize = 16;
+  uint64_t vertices_transformed = 0, triangle_num = 0, vertex_num = 0;
+  for (const auto& mesh : per_draw_call_model_index_set) {
+    if (mesh.index_buffer_len == 0 || mesh.vertex_num == 0) { continue; }
+    const auto stats = meshopt_analyzeVertexCache(mesh_buffers.index_buffer.data() + mesh.index_buffer_offset, mesh.index_buffer_len, mesh.vertex_num, kVertexCacheSize, 0, 0);
+    vertices_transformed += stats.vertices_transformed;
+    triangle_num += mesh.index_buffer_len / 3;
+    vertex_num += mesh.vertex_num;
   }
-  return MeshBuffers{
-    index_buffer,
-    vertex_buffer_position,
-    vertex_buffer_normal,
-    vertex_buffer_tangent,
-    vertex_buffer_texcoord,
+  if (triangle_num == 0 || vertex_num == 0) { return VertexCacheStatistics{}; }
+  return VertexCacheStatistics{
+    .acmr = static_cast<float>(vertices_transformed) / static_cast<float>(triangle_num),
+    .atvr = static_cast<float>(vertices_transformed) / static_cast<float>(vertex_num),
   };
 }
-auto GetFlattenedMatrixList(const std::vector<aiMatrix4x4>& matrix_list) {
-  if (matrix_list.empty()) { return std::vector<float>{}; }
-  assert(sizeof(matrix_list[0].a1) == 4);
-  const auto matrix_num = GetUint32(matrix_list.size());
-  const uint32_t kComponentNum = 16;
-  const auto kMatrixByteSize = GetUint32(sizeof(float)) * kComponentNum;
-  std::vector<float> float_list(kComponentNum * matrix_num);
-  for (uint32_t i = 0; i < matrix_num; i++) {
-    memcpy(float_list.data() + i * kComponentNum, &matrix_list[i].a1, kMatrixByteSize);
+void OptimizeMeshes(const uint32_t thread_num, const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set, MeshBuffers* mesh_buffers) {
+  const auto stats_before = AnalyzeVertexCache(per_draw_call_model_index_set, *mesh_buffers);
+  // each mesh only touches its own index and vertex ranges
+  ParallelFor(thread_num, GetUint32(per_draw_call_model_index_set.size()), [&](const uint32_t i) {
+    OptimizeMesh(per_draw_call_model_index_set[i], mesh_buffers);
+  });
+  const auto stats_after = AnalyzeVertexCache(per_draw_call_model_index_set, *mesh_buffers);
+  loginfo("mesh optimization acmr:{:.3f}->{:.3f} atvr:{:.3f}->{:.3f}", stats_before.acmr, stats_after.acmr, stats_before.atvr, stats_after.atvr);
+}
+void BuildLods(const std::vector<float>& target_ratios, const float target_error, MeshBuffers* mesh_buffers, std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
+  const uint32_t kTriangleVertexNum = 3;
+  std::vector<uint32_t> lod_index_buffer;
+  uint64_t index_num_before = 0, index_num_after = 0;
+  for (auto& mesh : *per_draw_call_model_index_set) {
+    mesh.lods.clear();
+    if (mesh.index_buffer_len == 0 || mesh.vertex_num == 0) { continue; }
+    const auto positions = mesh_buffers->vertex_buffer_position.data() + mesh.vertex_buffer_index_offset * 3;
+    const auto scale = meshopt_simplifyScale(positions, mesh.vertex_num, sizeof(float) * 3);
+    auto prev_index_num = mesh.index_buffer_len;
+    for (const auto ratio : target_ratios) {
+      const auto indices = mesh_buffers->index_buffer.data() + mesh.index_buffer_offset;
+      const auto target_index_num = static_cast<std::size_t>(static_cast<float>(mesh.index_buffer_len / kTriangleVertexNum) * ratio) * kTriangleVertexNum;
+      lod_index_buffer.resize(mesh.index_buffer_len);
+      float result_error = 0.0f;
+      // simplify from lod0 every time to avoid accumulating error
+      const auto index_num = GetUint32(meshopt_simplify(lod_index_buffer.data(), indices, mesh.index_buffer_len, positions, mesh.vertex_num, sizeof(float) * 3,
+                                                        target_index_num, target_error, 0, &result_error));
+      if (index_num == 0 || index_num >= prev_index_num) {
+        logdebug("lod{} not generated. target:{} result:{} prev:{}", mesh.lods.size() + 1, target_index_num, index_num, prev_index_num);
+        break;
+      }
+      lod_index_buffer.resize(index_num);
+      meshopt_optimizeVertexCache(lod_index_buffer.data(), lod_index_buffer.data(), index_num, mesh.vertex_num);
+      mesh.lods.push_back(LodIndexRange{
+          .index_buffer_offset = GetUint32(mesh_buffers->index_buffer.size()),
+          .index_buffer_len = index_num,
+          .error = result_error * scale,
+        });
+      mesh_buffers->index_buffer.insert(mesh_buffers->index_buffer.end(), lod_index_buffer.begin(), lod_index_buffer.end());
+      prev_index_num = index_num;
+    }
+    index_num_before += mesh.index_buffer_len;
+    index_num_after += prev_index_num;
   }
-  return float_list;
+  loginfo("lod triangles:{}->{}", index_num_before / kTriangleVertexNum, index_num_after / kTriangleVertexNum);
 }
-auto GetTransformMatrixList(aiNode* root_node, PerDrawCallModelIndexSet* per_draw_call_model_index_set) {
-  std::vector<aiMatrix4x4> transform_matrix_list;
-  aiMatrix4x4 transform_matrix;
-  PushTransformMatrix(root_node, kInvalidIndex, transform_matrix, per_draw_call_model_index_set, &transform_matrix_list);
-  return GetFlattenedMatrixList(std::move(transform_matrix_list));
+auto AlignUp(const std::size_t size, const std::size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
 }
-auto FlattenTransformIndexLists(const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set) {
-  std::vector<uint32_t> transform_index_list_offset, transform_index_list;
-  for (const auto& entity : per_draw_call_model_index_set) {
-    transform_index_list_offset.push_back(GetUint32(transform_index_list.size()));
-    for (const auto& index : entity.transform_matrix_index_list) {
-      transform_index_list.push_back(index);
+const uint32_t kMeshletComponentNum = 4;
+const uint32_t kMeshletBoundsComponentNum = 12;
+struct MeshletBuffers {
+  std::vector<uint32_t> meshlet; // vertex_offset, triangle_offset, vertex_count, triangle_count
+  std::vector<uint32_t> meshlet_vertices;
+  std::vector<uint8_t>  meshlet_triangles;
+  std::vector<float>    meshlet_bounds; // center.xyz, radius, cone_apex.xyz, (unused), cone_axis.xyz, cone_cutoff
+};
+auto BuildMeshlets(const uint32_t max_vertices, const uint32_t max_triangles, const MeshBuffers& mesh_buffers, std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
+  const float kConeWeight = 0.25f;
+  const uint32_t kTriangleAlignment = 4;
+  MeshletBuffers meshlet_buffers;
+  // limits from meshopt_buildMeshlets
+  if (max_vertices < 3 || max_vertices > 255 || max_triangles < 4 || max_triangles > 512 || max_triangles % 4 != 0) {
+    logerror("invalid meshlet size vertices:{} triangles:{}", max_vertices, max_triangles);
+    return meshlet_buffers;
+  }
+  for (auto& mesh : *per_draw_call_model_index_set) {
+    mesh.meshlet_offset = GetUint32(meshlet_buffers.meshlet.size() / kMeshletComponentNum);
+    mesh.meshlet_num = 0;
+    if (mesh.index_buffer_len == 0 || mesh.vertex_num == 0) { continue; }
+    const auto indices = mesh_buffers.index_buffer.data() + mesh.index_buffer_offset;
+    const auto positions = mesh_buffers.vertex_buffer_position.data() + mesh.vertex_buffer_index_offset * 3;
+    const auto max_meshlet_num = meshopt_buildMeshletsBound(mesh.index_buffer_len, max_vertices, max_triangles);
+    std::vector<meshopt_Meshlet> meshlets(max_meshlet_num);
+    std::vector<uint32_t> meshlet_vertices(max_meshlet_num * max_vertices);
+    std::vector<uint8_t> meshlet_triangles(max_meshlet_num * max_triangles * 3);
+    const auto meshlet_num = meshopt_buildMeshlets(meshlets.data(), meshlet_vertices.data(), meshlet_triangles.data(),
+                                                   indices, mesh.index_buffer_len, positions, mesh.vertex_num, sizeof(float) * 3,
+                                                   max_vertices, max_triangles, kConeWeight);
+    for (std::size_t i = 0; i < meshlet_num; i++) {
+      const auto& meshlet = meshlets[i];
+      const auto vertices = meshlet_vertices.data() + meshlet.vertex_offset;
+      const auto triangles = meshlet_triangles.data() + meshlet.triangle_offset;
+      const auto bounds = meshopt_computeMeshletBounds(vertices, triangles, meshlet.triangle_count, positions, mesh.vertex_num, sizeof(float) * 3);
+      meshlet_buffers.meshlet.insert(meshlet_buffers.meshlet.end(), {
+          GetUint32(meshlet_buffers.meshlet_vertices.size()),
+          GetUint32(meshlet_buffers.meshlet_triangles.size()),
+          meshlet.vertex_count,
+          meshlet.triangle_count,
+        });
+      meshlet_buffers.meshlet_vertices.insert(meshlet_buffers.meshlet_vertices.end(), vertices, vertices + meshlet.vertex_count);
+      meshlet_buffers.meshlet_triangles.insert(meshlet_buffers.meshlet_triangles.end(), triangles, triangles + meshlet.triangle_count * 3);
+      // keep each meshlet's triangle list 4 byte aligned for 32-bit loads in shaders
+      meshlet_buffers.meshlet_triangles.resize(AlignUp(meshlet_buffers.meshlet_triangles.size(), kTriangleAlignment));
+      meshlet_buffers.meshlet_bounds.insert(meshlet_buffers.meshlet_bounds.end(), {
+          bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius,
+          bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2], 0.0f,
+          bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2], bounds.cone_cutoff,
+        });
     }
+    mesh.meshlet_num = GetUint32(meshlet_num);
   }
-  return std::make_pair(transform_index_list_offset, transform_index_list);
+  assert(meshlet_buffers.meshlet_bounds.size() / kMeshletBoundsComponentNum == meshlet_buffers.meshlet.size() / kMeshletComponentNum);
+  return meshlet_buffers;
 }
-auto OutputBinaryToFile(const size_t file_size_in_byte, const void* buffer, std::ofstream* ofstream) {
-  ofstream->write(reinterpret_cast<const char*>(buffer), static_cast<std::streamsize>(file_size_in_byte));
+struct QuantizedMeshBuffers {
+  std::vector<uint16_t> vertex_buffer_position; // unorm16 xyz + unused w relative to mesh aabb. empty if position is not quantized.
+  std::vector<int16_t>  vertex_buffer_normal;   // octahedral snorm16 xy
+  std::vector<int16_t>  vertex_buffer_tangent;  // octahedral snorm16 xy, lsb of y is set for negative bitangent sign
+  std::vector<uint16_t> vertex_buffer_texcoord; // half or unorm16 relative to mesh uv range
+  bool texcoord_unorm16{false};
+};
+const uint32_t kQuantizedPositionComponentNum = 4;
+auto EncodeOctahedral(const float* v) {
+  const auto l1 = std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]);
+  if (l1 == 0.0f) { return std::make_pair(0.0f, 0.0f); }
+  auto x = v[0] / l1;
+  auto y = v[1] / l1;
+  if (v[2] < 0.0f) {
+    const auto wrapped_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+    const auto wrapped_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    x = wrapped_x;
+    y = wrapped_y;
+  }
+  return std::make_pair(x, y);
 }
-template <typename T>
-auto OutputBinaryToFile(const std::vector<T>& buffer, std::ofstream* ofstream) {
-  if (buffer.empty()) { return; }
-  OutputBinaryToFile(buffer.size() * sizeof(buffer[0]), buffer.data(), ofstream);
-}
-void OutputBinariesToFile(const std::vector<float>& transform_matrix_list,
-                          const std::vector<uint32_t>& transform_index_list_offset,
-                          const std::vector<uint32_t>& transform_index_list,
-                          const MeshBuffers& mesh_buffers,
-                          const char* const filename) {
-  std::ofstream output_file(filename, std::ios::out | std::ios::binary);
-  // call order to OutputBinaryToFile must match that of CreateJsonBinaryEntity
-  OutputBinaryToFile(transform_index_list_offset, &output_file);
-  OutputBinaryToFile(transform_index_list, &output_file);
-  OutputBinaryToFile(transform_matrix_list, &output_file);
-  OutputBinaryToFile(mesh_buffers.index_buffer, &output_file);
-  OutputBinaryToFile(mesh_buffers.vertex_buffer_position, &output_file);
-  OutputBinaryToFile(mesh_buffers.vertex_buffer_normal, &output_file);
-  OutputBinaryToFile(mesh_buffers.vertex_buffer_tangent, &output_file);
-  OutputBinaryToFile(mesh_buffers.vertex_buffer_texcoord, &output_file);
-}
-auto CreateJsonBinaryEntity(const std::size_t& size_in_bytes, const std::size_t& stride_in_bytes, const uint32_t offset_in_bytes) {
-  nlohmann::json json;
-  json["size_in_bytes"] = size_in_bytes;
-  json["stride_in_bytes"] = stride_in_bytes;
-  json["offset_in_bytes"] = offset_in_bytes;
-  return json;
+template <uint32_t N>
+auto GetBounds(const float* buffer, const uint32_t element_num, float* min, float* max) {
+  for (uint32_t i = 0; i < N; i++) {
+    min[i] = std::numeric_limits<float>::max();
+    max[i] = std::numeric_limits<float>::lowest();
+  }
+  for (uint32_t i = 0; i < element_num; i++) {
+    for (uint32_t j = 0; j < N; j++) {
+      min[j] = std::min(min[j], buffer[i * N + j]);
+      max[j] = std::max(max[j], buffer[i * N + j]);
+    }
+  }
 }
-template <typename T>
-auto CreateJsonBinaryEntity(const std::vector<T>& vector, const uint32_t component_num, const uint32_t offset_in_bytes) {
-  if (vector.empty()) {
-    return CreateJsonBinaryEntity(0, 0, offset_in_bytes);
+template <uint32_t N>
+auto GetDequantizeParams(const float* buffer, const uint32_t element_num, float* offset, float* scale) {
+  float max[N];
+  GetBounds<N>(buffer, element_num, offset, max);
+  for (uint32_t i = 0; i < N; i++) {
+    scale[i] = max[i] - offset[i];
+    if (scale[i] <= 0.0f) { scale[i] = 1.0f; }
   }
-  const auto element_num = vector.size();
-  const auto per_node_size_in_bytes = sizeof(vector[0]);
-  return CreateJsonBinaryEntity(element_num * per_node_size_in_bytes, per_node_size_in_bytes * component_num, offset_in_bytes);
 }
-auto CreateMeshJson(const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set) {
-  auto json = nlohmann::json::array();
-  const auto mesh_num = per_draw_call_model_index_set.size();
-  for (uint32_t i = 0; i < mesh_num; i++) {
-    const auto& mesh = per_draw_call_model_index_set[i];
-    nlohmann::json elem;
-    elem["instance_num"] = mesh.transform_matrix_index_list.size();
-    elem["index_buffer_offset"] = mesh.index_buffer_offset;
-    elem["index_buffer_len"] = mesh.index_buffer_len;
-    elem["vertex_buffer_index_offset"] = mesh.vertex_buffer_index_offset;
-    elem["vertex_num"] = mesh.vertex_num;
-    elem["material_index"] = mesh.material_index;
-    json.emplace_back(std::move(elem));
+auto QuantizeUnorm16(const float val, const float offset, const float scale) {
+  return static_cast<uint16_t>(meshopt_quantizeUnorm((val - offset) / scale, 16));
+}
+auto QuantizeSnorm16(const float val) {
+  return static_cast<int16_t>(meshopt_quantizeSnorm(val, 16));
+}
+auto QuantizeMeshBuffers(const bool quantize_position, const bool texcoord_unorm16, const MeshBuffers& mesh_buffers, std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
+  QuantizedMeshBuffers quantized;
+  quantized.texcoord_unorm16 = texcoord_unorm16;
+  const auto vertex_num = GetUint32(mesh_buffers.vertex_buffer_position.size() / 3);
+  const auto valid_texcoord = mesh_buffers.vertex_buffer_texcoord.size() == vertex_num * 2;
+  if (quantize_position) {
+    quantized.vertex_buffer_position.resize(vertex_num * kQuantizedPositionComponentNum);
   }
-  return json;
+  quantized.vertex_buffer_normal.resize(vertex_num * 2);
+  quantized.vertex_buffer_tangent.resize(vertex_num * 2);
+  if (valid_texcoord) {
+    quantized.vertex_buffer_texcoord.resize(vertex_num * 2);
+  }
+  for (auto& mesh : *per_draw_call_model_index_set) {
+    const auto vertex_offset = mesh.vertex_buffer_index_offset;
+    if (quantize_position) {
+      const auto positions = mesh_buffers.vertex_buffer_position.data() + vertex_offset * 3;
+      GetDequantizeParams<3>(positions, mesh.vertex_num, mesh.position_offset, mesh.position_scale);
+      for (uint32_t i = 0; i < mesh.vertex_num; i++) {
+        auto dst = quantized.vertex_buffer_position.data() + (vertex_offset + i) * kQuantizedPositionComponentNum;
+        for (uint32_t j = 0; j < 3; j++) {
+          dst[j] = QuantizeUnorm16(positions[i * 3 + j], mesh.position_offset[j], mesh.position_scale[j]);
+        }
+        dst[3] = 0;
+      }
+    }
+    for (uint32_t i = 0; i < mesh.vertex_num; i++) {
+      const auto index = vertex_offset + i;
+      const auto [normal_x, normal_y] = EncodeOctahedral(&mesh_buffers.vertex_buffer_normal[index * 3]);
+      quantized.vertex_buffer_normal[index * 2]     = QuantizeSnorm16(normal_x);
+      quantized.vertex_buffer_normal[index * 2 + 1] = QuantizeSnorm16(normal_y);
+      const auto [tangent_x, tangent_y] = EncodeOctahedral(&mesh_buffers.vertex_buffer_tangent[index * 3]);
+      const auto negative_sign = mesh_buffers.vertex_buffer_tangent_sign.size() > index && mesh_buffers.vertex_buffer_tangent_sign[index] < 0;
+      quantized.vertex_buffer_tangent[index * 2]     = QuantizeSnorm16(tangent_x);
+      quantized.vertex_buffer_tangent[index * 2 + 1] = static_cast<int16_t>((QuantizeSnorm16(tangent_y) & ~1) | (negative_sign ? 1 : 0));
+    }
+    if (!valid_texcoord) { continue; }
+    const auto texcoords = mesh_buffers.vertex_buffer_texcoord.data() + vertex_offset * 2;
+    if (texcoord_unorm16) {
+      GetDequantizeParams<2>(texcoords, mesh.vertex_num, mesh.texcoord_offset, mesh.texcoord_scale);
+    }
+    for (uint32_t i = 0; i < mesh.vertex_num * 2; i++) {
+      quantized.vertex_buffer_texcoord[vertex_offset * 2 + i] = texcoord_unorm16 ? QuantizeUnorm16(texcoords[i], mesh.texcoord_offset[i % 2], mesh.texcoord_scale[i % 2]) : meshopt_quantizeHalf(texcoords[i]);
+    }
+  }
+  return quantized;
 }
 template <typename T>
-auto GetVectorSizeInBytes(const std::vector<T>& vector) {
-  return GetUint32(vector.size() * sizeof(vector[0]));
+constexpr auto GetComponentFormat() {
+  if constexpr (std::is_same_v<T, float>)    { return ComponentFormat::kFloat32; }
+  if constexpr (std::is_same_v<T, uint32_t>) { return ComponentFormat::kUint32; }
+  if constexpr (std::is_same_v<T, uint16_t>) { return ComponentFormat::kUnorm16; }
+  if constexpr (std::is_same_v<T, int16_t>)  { return ComponentFormat::kSnorm16; }
+  if constexpr (std::is_same_v<T, uint8_t>)  { return ComponentFormat::kUint8; }
+  if constexpr (std::is_class_v<T>)          { return ComponentFormat::kStruct; }
 }
-auto CreateJsonBinaryEntityList(const std::vector<float>& transform_matrix_list,
-                                const std::vector<uint32_t>& transform_index_list_offset,
-                                const std::vector<uint32_t>& transform_index_list,
-                                const MeshBuffers& mesh_buffers) {
-  nlohmann::json json;
-  // call order to CreateJsonBinaryEntity must match that of OutputBinaryToFile
-  uint32_t offset_in_bytes = 0;
-  json["transform_offset"] = CreateJsonBinaryEntity(transform_index_list_offset, 16, offset_in_bytes);
-  offset_in_bytes         += GetVectorSizeInBytes(transform_index_list_offset);
-  json["transform_index"]  = CreateJsonBinaryEntity(transform_index_list, 1, offset_in_bytes);
-  offset_in_bytes         += GetVectorSizeInBytes(transform_index_list);
-  json["transform"] = CreateJsonBinaryEntity(transform_matrix_list, 16, offset_in_bytes);
-  offset_in_bytes  += GetVectorSizeInBytes(transform_matrix_list);
-  json["index"]     = CreateJsonBinaryEntity(mesh_buffers.index_buffer, 1, offset_in_bytes);
-  offset_in_bytes  += GetVectorSizeInBytes(mesh_buffers.index_buffer);
-  json["position"]  = CreateJsonBinaryEntity(mesh_buffers.vertex_buffer_position, 3, offset_in_bytes);
-  offset_in_bytes  += GetVectorSizeInBytes(mesh_buffers.vertex_buffer_position);
-  json["normal"]    = CreateJsonBinaryEntity(mesh_buffers.vertex_buffer_normal, 3, offset_in_bytes);
-  offset_in_bytes  += GetVectorSizeInBytes(mesh_buffers.vertex_buffer_normal);
-  json["tangent"]   = CreateJsonBinaryEntity(mesh_buffers.vertex_buffer_tangent, 3, offset_in_bytes);
-  offset_in_bytes  += GetVectorSizeInBytes(mesh_buffers.vertex_buffer_tangent);
-  json["texcoord"]  = CreateJsonBinaryEntity(mesh_buffers.vertex_buffer_texcoord, 2, offset_in_bytes);
-  return json;
+struct VertexAttribute {
+  SectionType semantic{SectionType::kPosition};
+  ComponentFormat format{ComponentFormat::kUnknown};
+  uint32_t component_num{0};
+  uint32_t size_in_bytes{0};   // per vertex
+  uint32_t offset_in_bytes{0}; // in stride
+  AttributeEncoding encoding{AttributeEncoding::kNone};
+};
+// a section of the output binary
+struct BinaryStream {
+  SectionType type{SectionType::kPosition};
+  const void* buffer{nullptr};
+  std::size_t size_in_bytes{0};
+  uint32_t stride_in_bytes{0};
+  std::vector<VertexAttribute> attributes;
+  uint32_t attribute_offset{0}; // to kVertexAttribute section, for interleaved stream
+  uint32_t mesh_index{kInvalidIndex}; // for streams grouped per mesh
+  uint64_t offset_in_bytes{0};  // in chunk file, set by LayoutSections
+  uint32_t padding_in_bytes{0}; // before this section, set by LayoutSections
+  uint32_t chunk_index{0};      // set by LayoutSections
+};
+auto GetComponentSizeInBytes(const ComponentFormat format) {
+  switch (format) {
+    case ComponentFormat::kUint8:
+      return 1U;
+    case ComponentFormat::kFloat16:
+    case ComponentFormat::kUint16:
+    case ComponentFormat::kUnorm16:
+    case ComponentFormat::kSnorm16:
+      return 2U;
+    default:
+      return 4U;
+  }
 }
-void WriteOutJson(const nlohmann::json& json, const char* const filename) {
-  std::ofstream output_stream(filename);
-  output_stream << std::setw(2) << json << std::endl;
+template <typename T>
+auto CreateBinaryStream(const SectionType type, const std::vector<T>& buffer, const uint32_t component_num, const ComponentFormat format = GetComponentFormat<T>(), const AttributeEncoding encoding = AttributeEncoding::kNone) {
+  const auto stride_in_bytes = format == ComponentFormat::kStruct ? GetUint32(sizeof(T)) : GetComponentSizeInBytes(format) * component_num;
+  return BinaryStream{
+    .type = type,
+    .buffer = buffer.data(),
+    .size_in_bytes = buffer.size() * sizeof(T),
+    .stride_in_bytes = stride_in_bytes,
+    .attributes = {VertexAttribute{
+        .semantic = type,
+        .format = format,
+        .component_num = component_num,
+        .size_in_bytes = stride_in_bytes,
+        .offset_in_bytes = 0,
+        .encoding = encoding,
+      }},
+  };
 }
-auto GetFilenameStem(const char* const filename) {
-  std::string str(filename);
-  auto slash_pos = str.find_last_of('/');
-  auto period_pos = str.find_last_of('.');
-  if (slash_pos == std::string::npos) {
-    slash_pos = 0;
+auto CreateSeparateVertexStreams(const MeshBuffers& mesh_buffers, const QuantizedMeshBuffers* quantized_mesh_buffers) {
+  std::vector<BinaryStream> streams;
+  if (quantized_mesh_buffers == nullptr || quantized_mesh_buffers->vertex_buffer_position.empty()) {
+    streams.push_back(CreateBinaryStream(SectionType::kPosition, mesh_buffers.vertex_buffer_position, 3));
   } else {
-    slash_pos++;
-    if (slash_pos >= str.length()) {
-      logerror("invalid filename {} {}", str.c_str(), slash_pos);
-      slash_pos = str.length() - 1;
+    streams.push_back(CreateBinaryStream(SectionType::kPosition, quantized_mesh_buffers->vertex_buffer_position, kQuantizedPositionComponentNum));
+  }
+  if (quantized_mesh_buffers == nullptr) {
+    streams.push_back(CreateBinaryStream(SectionType::kNormal, mesh_buffers.vertex_buffer_normal, 3));
+    streams.push_back(CreateBinaryStream(SectionType::kTangent, mesh_buffers.vertex_buffer_tangent, 3));
+    streams.push_back(CreateBinaryStream(SectionType::kTexcoord, mesh_buffers.vertex_buffer_texcoord, 2));
+  } else {
+    streams.push_back(CreateBinaryStream(SectionType::kNormal, quantized_mesh_buffers->vertex_buffer_normal, 2, ComponentFormat::kSnorm16, AttributeEncoding::kOctahedral));
+    streams.push_back(CreateBinaryStream(SectionType::kTangent, quantized_mesh_buffers->vertex_buffer_tangent, 2, ComponentFormat::kSnorm16, AttributeEncoding::kOctahedralWithSignBit));
+    streams.push_back(CreateBinaryStream(SectionType::kTexcoord, quantized_mesh_buffers->vertex_buffer_texcoord, 2, quantized_mesh_buffers->texcoord_unorm16 ? ComponentFormat::kUnorm16 : ComponentFormat::kFloat16));
+  }
+  return streams;
+}
+auto InterleaveVertexStreams(const std::vector<BinaryStream>& streams, std::vector<uint8_t>* interleaved_buffer) {
+  BinaryStream interleaved;
+  interleaved.type = SectionType::kInterleaved;
+  std::size_t vertex_num = 0;
+  for (const auto& stream : streams) {
+    if (stream.size_in_bytes == 0) { continue; }
+    const auto stream_vertex_num = stream.size_in_bytes / stream.stride_in_bytes;
+    assert(vertex_num == 0 || vertex_num == stream_vertex_num);
+    vertex_num = stream_vertex_num;
+    for (auto attribute : stream.attributes) {
+      attribute.offset_in_bytes += interleaved.stride_in_bytes;
+      interleaved.attributes.push_back(attribute);
     }
+    interleaved.stride_in_bytes += stream.stride_in_bytes;
   }
-  if (period_pos == std::string::npos) {
-    period_pos = str.length();
+  interleaved_buffer->resize(vertex_num * interleaved.stride_in_bytes);
+  uint32_t offset_in_stride = 0;
+  for (const auto& stream : streams) {
+    if (stream.size_in_bytes == 0) { continue; }
+    const auto src = static_cast<const uint8_t*>(stream.buffer);
+    for (std::size_t i = 0; i < vertex_num; i++) {
+      memcpy(interleaved_buffer->data() + i * interleaved.stride_in_bytes + offset_in_stride, src + i * stream.stride_in_bytes, stream.stride_in_bytes);
+    }
+    offset_in_stride += stream.stride_in_bytes;
   }
-  return str.substr(slash_pos, period_pos - slash_pos);
+  interleaved.buffer = interleaved_buffer->data();
+  interleaved.size_in_bytes = interleaved_buffer->size();
+  return interleaved;
 }
-auto MergeStrings(const char* const str1, const char str2, const char* const str3) {
-  const uint32_t kBufferLen = 128;
-  char buffer[kBufferLen];
-  const auto result = snprintf(buffer, kBufferLen, "%s%c%s", str1, str2, str3);
-  if (result > 0 && result < kBufferLen) {
-    return std::string(buffer);
+auto CreateVertexStreams(const VertexLayout vertex_layout, std::vector<BinaryStream>&& separate_streams, std::vector<uint8_t>* interleaved_buffer) {
+  switch (vertex_layout) {
+    case VertexLayout::kSeparate:
+      return std::move(separate_streams);
+    case VertexLayout::kPositionAndInterleaved: {
+      const std::vector<BinaryStream> attribute_streams(separate_streams.begin() + 1, separate_streams.end());
+      return std::vector<BinaryStream>{separate_streams[0], InterleaveVertexStreams(attribute_streams, interleaved_buffer)};
+    }
+    case VertexLayout::kInterleaved:
+      return std::vector<BinaryStream>{InterleaveVertexStreams(separate_streams, interleaved_buffer)};
   }
-  logerror("snprintf error:{} {} {} {}", result, str1, str2, str3);
-  return std::string();
+  return std::move(separate_streams);
 }
-auto GetOutputFilename(const char* const basename, const char* const extension) {
-  return MergeStrings(basename, '.', extension);
+const uint32_t kIndexBufferAlignment = 4;
+const uint32_t kMaxUint16IndexVertexNum = 0xFFFF; // 0xFFFF itself is left unused as it is the strip cut value
+auto AppendIndices(const uint32_t* indices, const uint32_t index_num, const uint32_t index_stride_in_bytes, std::vector<uint8_t>* index_buffer) {
+  index_buffer->resize(AlignUp(index_buffer->size(), kIndexBufferAlignment));
+  const uint64_t offset_in_bytes = index_buffer->size();
+  index_buffer->resize(offset_in_bytes + std::size_t{index_num} * index_stride_in_bytes);
+  auto dst = index_buffer->data() + offset_in_bytes;
+  if (index_stride_in_bytes == sizeof(uint32_t)) {
+    memcpy(dst, indices, index_num * sizeof(uint32_t));
+    return offset_in_bytes;
+  }
+  for (uint32_t i = 0; i < index_num; i++) {
+    const auto index = static_cast<uint16_t>(indices[i]);
+    memcpy(dst + i * sizeof(uint16_t), &index, sizeof(uint16_t));
+  }
+  return offset_in_bytes;
 }
-auto GetOutputFilePath(const char* const directory, const char* const filename) {
-  return MergeStrings(directory, '/', filename);
+auto GetIndexStrideInBytes(const bool narrow_index_buffer, const uint32_t vertex_num) {
+  return GetUint32(narrow_index_buffer && vertex_num <= kMaxUint16IndexVertexNum ? sizeof(uint16_t) : sizeof(uint32_t));
 }
-auto GetShadingMode(const aiMaterial& material) {
-  int32_t shading_mode;
-  if (const auto result = material.Get(AI_MATKEY_SHADING_MODEL, shading_mode); result != AI_SUCCESS) {
-    logerror("failed to retrieve AI_MATKEY_SHADING_MODEL {}", result);
-    return 0;
+auto CreateIndexStreamFromBuffer(const std::vector<uint8_t>& index_buffer, const uint32_t uint16_mesh_num, const uint32_t uint32_mesh_num) {
+  if (uint32_mesh_num == 0) {
+    return CreateBinaryStream(SectionType::kIndex, index_buffer, 1, ComponentFormat::kUint16);
   }
-  return shading_mode;
+  if (uint16_mesh_num == 0) {
+    return CreateBinaryStream(SectionType::kIndex, index_buffer, 1, ComponentFormat::kUint32);
+  }
+  // mixed formats, see index_format of each mesh
+  auto stream = CreateBinaryStream(SectionType::kIndex, index_buffer, 1, ComponentFormat::kPerMesh);
+  stream.stride_in_bytes = 0;
+  return stream;
 }
-auto GetMaterialVal(const aiMaterial& material, const char * const key, const uint32_t type, const uint32_t idx, std::vector<float>&& default_val) {
-  aiColor4D color;
-  if (const auto result = material.Get(key, type, idx, color); result != AI_SUCCESS) {
-    logwarn("material: failed to get {} {} {} {}", key, type, idx, result);
-    return default_val;
+// matches offsets computed by AppendIndices
+auto GetNarrowedIndexBufferSize(const bool narrow_index_buffer, const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set) {
+  std::size_t size_in_bytes = 0;
+  for (const auto& mesh : per_draw_call_model_index_set) {
+    if (mesh.index_buffer_len == 0) { continue; }
+    const auto index_stride_in_bytes = GetIndexStrideInBytes(narrow_index_buffer, mesh.vertex_num);
+    size_in_bytes = AlignUp(size_in_bytes, kIndexBufferAlignment) + std::size_t{mesh.index_buffer_len} * index_stride_in_bytes;
+    for (const auto& lod : mesh.lods) {
+      size_in_bytes = AlignUp(size_in_bytes, kIndexBufferAlignment) + std::size_t{lod.index_buffer_len} * index_stride_in_bytes;
+    }
   }
-  return std::vector{color.r, color.g, color.b, color.a};
+  return AlignUp(size_in_bytes, kIndexBufferAlignment);
 }
-auto GetMaterialVal(const aiMaterial& material, const char * const key, const uint32_t type, const uint32_t idx, const float default_val) {
-  float val{default_val};
-  if (const auto result = material.Get(key, type, idx, val); result != AI_SUCCESS) {
-    logwarn("material: failed to get {} {} {} {}", key, type, idx, result);
+auto CreateIndexStream(const bool narrow_index_buffer, const bool contiguous_per_mesh, const std::vector<uint32_t>& index_buffer, std::vector<uint8_t>* narrowed_index_buffer, std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
+  // lods are appended after all lod0 indices in index_buffer, repacked below to keep each mesh's indices contiguous
+  if (!narrow_index_buffer && !contiguous_per_mesh) {
+    for (auto& mesh : *per_draw_call_model_index_set) {
+      mesh.index_stride_in_bytes = sizeof(uint32_t);
+      mesh.index_buffer_offset_in_bytes = uint64_t{mesh.index_buffer_offset} * sizeof(uint32_t);
+      for (auto& lod : mesh.lods) {
+        lod.index_buffer_offset_in_bytes = uint64_t{lod.index_buffer_offset} * sizeof(uint32_t);
+      }
+    }
+    return CreateBinaryStream(SectionType::kIndex, index_buffer, 1);
   }
-  return val;
+  narrowed_index_buffer->clear();
+  narrowed_index_buffer->reserve(GetNarrowedIndexBufferSize(narrow_index_buffer, *per_draw_call_model_index_set));
+  uint32_t uint16_mesh_num = 0, uint32_mesh_num = 0;
+  for (auto& mesh : *per_draw_call_model_index_set) {
+    if (mesh.index_buffer_len == 0) { continue; }
+    mesh.index_stride_in_bytes = GetIndexStrideInBytes(narrow_index_buffer, mesh.vertex_num);
+    mesh.index_buffer_offset_in_bytes = AppendIndices(&index_buffer[mesh.index_buffer_offset], mesh.index_buffer_len, mesh.index_stride_in_bytes, narrowed_index_buffer);
+    for (auto& lod : mesh.lods) {
+      lod.index_buffer_offset_in_bytes = AppendIndices(&index_buffer[lod.index_buffer_offset], lod.index_buffer_len, mesh.index_stride_in_bytes, narrowed_index_buffer);
+    }
+    if (mesh.index_stride_in_bytes == sizeof(uint16_t)) {
+      uint16_mesh_num++;
+    } else {
+      uint32_mesh_num++;
+    }
+  }
+  narrowed_index_buffer->resize(AlignUp(narrowed_index_buffer->size(), kIndexBufferAlignment));
+  loginfo("index buffer {}->{} bytes. uint16 mesh:{} uint32 mesh:{}", index_buffer.size() * sizeof(uint32_t), narrowed_index_buffer->size(), uint16_mesh_num, uint32_mesh_num);
+  return CreateIndexStreamFromBuffer(*narrowed_index_buffer, uint16_mesh_num, uint32_mesh_num);
 }
-auto GetMaterialVal(const aiMaterial& material, const char * const key, const uint32_t type, const uint32_t idx, const bool default_val) {
-  bool val{default_val};
-  if (const auto result = material.Get(key, type, idx, val); result != AI_SUCCESS) {
-    logwarn("material: failed to get {} {} {} {}", key, type, idx, result);
+auto GetVertexLayoutName(const VertexLayout vertex_layout) {
+  switch (vertex_layout) {
+    case VertexLayout::kSeparate:
+      return "separate";
+    case VertexLayout::kPositionAndInterleaved:
+      return "position_and_interleaved";
+    case VertexLayout::kInterleaved:
+      return "interleaved";
   }
-  return val;
+  return "separate";
 }
-auto GetMaterialStrVal(const aiMaterial& material, const char * const key, const uint32_t type, const uint32_t idx, std::string&& default_val) {
-  aiString val;
-  if (const auto result = material.Get(key, type, idx, val); result != AI_SUCCESS) {
-    logwarn("material: failed to get {} {} {} {}", key, type, idx, result);
-    return default_val;
+// float x 16 per matrix
+auto GetTransformMatrixList(aiNode* root_node, PerDrawCallModelIndexSet* per_draw_call_model_index_set) {
+  std::vector<float> transform_matrix_list;
+  aiMatrix4x4 transform_matrix;
+  PushTransformMatrix(root_node, kInvalidIndex, transform_matrix, per_draw_call_model_index_set, &transform_matrix_list);
+  return transform_matrix_list;
+}
+auto FlattenTransformIndexLists(const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set) {
+  std::size_t transform_index_num = 0;
+  for (const auto& entity : per_draw_call_model_index_set) {
+    transform_index_num += entity.transform_matrix_index_list.size();
   }
-  return std::string(val.data);
+  std::vector<uint32_t> transform_index_list_offset, transform_index_list;
+  transform_index_list_offset.reserve(per_draw_call_model_index_set.size());
+  transform_index_list.reserve(transform_index_num);
+  for (const auto& entity : per_draw_call_model_index_set) {
+    transform_index_list_offset.push_back(GetUint32(transform_index_list.size()));
+    transform_index_list.insert(transform_index_list.end(), entity.transform_matrix_index_list.begin(), entity.transform_matrix_index_list.end());
+  }
+  return std::make_pair(std::move(transform_index_list_offset), std::move(transform_index_list));
 }
-struct Texture {
-  aiTextureType texture_type{static_cast<aiTextureType>(-1)};
-  std::string path;
-};
-struct Sampler {
-  static const uint32_t kMapModeNum = 3;
-  aiTextureMapMode mapmode[kMapModeNum];
-  uint32_t mag_filter;
-  uint32_t min_filter;
-};
-auto IsValidMapMode(const aiTextureMapMode mapmode) {
-  switch (mapmode) {
-    case aiTextureMapMode_Wrap:
-      return true;
-    case aiTextureMapMode_Clamp:
-      return true;
-    case aiTextureMapMode_Decal:
-      return true;
-    case aiTextureMapMode_Mirror:
-      return true;
+auto GetSectionName(const SectionType type) {
+  switch (type) {
+    case SectionType::kTransformOffset:  return "transform_offset";
+    case SectionType::kTransformIndex:   return "transform_index";
+    case SectionType::kTransform:        return "transform";
+    case SectionType::kIndex:            return "index";
+    case SectionType::kPosition:         return "position";
+    case SectionType::kNormal:           return "normal";
+    case SectionType::kTangent:          return "tangent";
+    case SectionType::kTexcoord:         return "texcoord";
+    case SectionType::kInterleaved:      return "interleaved";
+    case SectionType::kMeshlet:          return "meshlet";
+    case SectionType::kMeshletVertices:  return "meshlet_vertices";
+    case SectionType::kMeshletTriangles: return "meshlet_triangles";
+    case SectionType::kMeshletBounds:    return "meshlet_bounds";
+    case SectionType::kMesh:             return "mesh";
+    case SectionType::kLod:              return "lod";
+    case SectionType::kMaterial:         return "material";
+    case SectionType::kTexture:          return "texture";
+    case SectionType::kSampler:          return "sampler";
+    case SectionType::kString:           return "string";
+    case SectionType::kVertexAttribute:  return "vertex_attribute";
+    case SectionType::kMeshBounds:       return "mesh_bounds";
+    case SectionType::kInstanceBounds:   return "instance_bounds";
+    case SectionType::kBvhNode:          return "bvh_node";
+    case SectionType::kBvhInstance:      return "bvh_instance";
+    case SectionType::kCell:             return "cell";
+    case SectionType::kNum:              break;
   }
-  return false;
+  return "unknown";
 }
-bool IsMapModeIdentical(const aiTextureMapMode* a, const aiTextureMapMode* b) {
-  for (uint32_t i = 0; i < Sampler::kMapModeNum; i++) {
-    if (!IsValidMapMode(a[i]) && !IsValidMapMode(b[i])) { continue; }
-    if (a[i] != b[i]) { return false; }
+auto GetComponentFormatName(const ComponentFormat format) {
+  switch (format) {
+    case ComponentFormat::kUnknown:     return "unknown";
+    case ComponentFormat::kFloat32:     return "float32";
+    case ComponentFormat::kFloat16:     return "float16";
+    case ComponentFormat::kUint32:      return "uint32";
+    case ComponentFormat::kUint16:      return "uint16";
+    case ComponentFormat::kUint8:       return "uint8";
+    case ComponentFormat::kUnorm16:     return "unorm16";
+    case ComponentFormat::kSnorm16:     return "snorm16";
+    case ComponentFormat::kPerMesh:     return "per_mesh";
+    case ComponentFormat::kInterleaved: return "interleaved";
+    case ComponentFormat::kStruct:      return "struct";
   }
-  return true;
+  return "unknown";
 }
-const uint32_t kInvalidTexture = ~0U;
-auto GetTextureIndex(const aiTextureType texture_type, const char* const path, const std::vector<Texture>& textures) {
-  const auto count = GetUint32(textures.size());
-  for (uint32_t i = 0; i < count; i++) {
-    const auto& texture = textures[i];
-    if (texture_type != texture.texture_type) { continue; }
-    if (strcmp(path, texture.path.c_str()) != 0) { continue; }
-    return i;
+auto GetAttributeEncodingName(const AttributeEncoding encoding) -> const char* {
+  switch (encoding) {
+    case AttributeEncoding::kNone:                  return nullptr;
+    case AttributeEncoding::kOctahedral:            return "octahedral";
+    case AttributeEncoding::kOctahedralWithSignBit: return "octahedral_with_sign_bit";
   }
-  return kInvalidTexture;
+  return nullptr;
 }
-auto CreateTexture(const aiTextureType texture_type, const char* const path) {
-  return Texture{
-    .texture_type = texture_type,
-    .path = path,
-  };
+const uint32_t kMinSectionAlignment = 16; // largest member alignment of container tables
+// plain data tables written to the container
+struct ContainerTables {
+  std::vector<MeshEntry> meshes;
+  std::vector<LodEntry> lods;
+  std::vector<MaterialEntry> materials;
+  std::vector<TextureEntry> textures;
+  std::vector<SamplerEntry> samplers;
+  std::vector<char> strings;
+  std::vector<VertexAttributeEntry> vertex_attributes;
+  // filled before CreateSectionList, see CreateBoundsTables
+  std::vector<MeshBoundsEntry> mesh_bounds;
+  std::vector<InstanceBoundsEntry> instance_bounds;
+  std::vector<BvhNodeEntry> bvh_nodes;
+  std::vector<uint32_t> bvh_instances;
+};
+template <typename T>
+void CopyDequantizeParams(const PerDrawCallModelIndexSet& mesh, T* dst) {
+  std::copy(std::begin(mesh.position_offset), std::end(mesh.position_offset), dst->position_offset);
+  std::copy(std::begin(mesh.position_scale), std::end(mesh.position_scale), dst->position_scale);
+  std::copy(std::begin(mesh.texcoord_offset), std::end(mesh.texcoord_offset), dst->texcoord_offset);
+  std::copy(std::begin(mesh.texcoord_scale), std::end(mesh.texcoord_scale), dst->texcoord_scale);
 }
-const uint32_t kInvalidSampler = ~0U;
-auto GetSamplerIndex(const aiTextureMapMode mapmode[3], const uint32_t mag_filter, const uint32_t min_filter, const std::vector<Sampler>& samplers) {
-  const auto count = GetUint32(samplers.size());
-  for (uint32_t i = 0; i < count; i++) {
-    const auto& sampler = samplers[i];
-    if (!IsMapModeIdentical(mapmode, sampler.mapmode)) { continue; }
-    if (mag_filter != sampler.mag_filter) { continue; }
-    if (min_filter != sampler.min_filter) { continue; }
-    return i;
+void CreateMeshTable(const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set, ContainerTables* tables) {
+  for (const auto& mesh : per_draw_call_model_index_set) {
+    MeshEntry entry{};
+    entry.index_stride_in_bytes = mesh.index_stride_in_bytes;
+    entry.index_buffer_len = mesh.index_buffer_len;
+    entry.index_buffer_offset_in_bytes = mesh.index_buffer_offset_in_bytes;
+    entry.vertex_buffer_index_offset = mesh.vertex_buffer_index_offset;
+    entry.vertex_num = mesh.vertex_num;
+    entry.material_index = mesh.material_index;
+    entry.instance_num = GetUint32(mesh.transform_matrix_index_list.size());
+    entry.meshlet_offset = mesh.meshlet_offset;
+    entry.meshlet_num = mesh.meshlet_num;
+    entry.lod_offset = GetUint32(tables->lods.size());
+    entry.lod_num = GetUint32(mesh.lods.size()) + 1;
+    CopyDequantizeParams(mesh, &entry);
+    tables->meshes.push_back(entry);
+    tables->lods.push_back(LodEntry{.index_buffer_offset_in_bytes = mesh.index_buffer_offset_in_bytes, .index_buffer_len = mesh.index_buffer_len, .error = 0.0f});
+    for (const auto& lod : mesh.lods) {
+      tables->lods.push_back(LodEntry{.index_buffer_offset_in_bytes = lod.index_buffer_offset_in_bytes, .index_buffer_len = lod.index_buffer_len, .error = lod.error});
+    }
   }
-  return kInvalidSampler;
 }
-constexpr auto CreateSampler(const aiTextureMapMode mapmode[3], const uint32_t mag_filter, const uint32_t min_filter) {
-  return Sampler{
-    .mapmode = {mapmode[0], mapmode[1], mapmode[2]},
-    .mag_filter = mag_filter,
-    .min_filter = min_filter,
-  };
+auto CreateMeshBounds(const aiMesh& mesh) {
+  // empty meshes get an inverted aabb and are skipped when building the bvh
+  MeshBoundsEntry bounds{};
+  std::fill(std::begin(bounds.aabb_min), std::end(bounds.aabb_min), std::numeric_limits<float>::max());
+  std::fill(std::begin(bounds.aabb_max), std::end(bounds.aabb_max), std::numeric_limits<float>::lowest());
+  if (mesh.mNumVertices == 0 || mesh.mVertices == nullptr) { return bounds; }
+  for (uint32_t i = 0; i < mesh.mNumVertices; i++) {
+    const float position[] = {mesh.mVertices[i].x, mesh.mVertices[i].y, mesh.mVertices[i].z};
+    for (uint32_t j = 0; j < 3; j++) {
+      bounds.aabb_min[j] = std::min(bounds.aabb_min[j], position[j]);
+      bounds.aabb_max[j] = std::max(bounds.aabb_max[j], position[j]);
+    }
+  }
+  // sphere around the aabb center, tighter than the aabb's circumscribed sphere
+  for (uint32_t j = 0; j < 3; j++) {
+    bounds.sphere_center[j] = (bounds.aabb_min[j] + bounds.aabb_max[j]) * 0.5f;
+  }
+  float radius_sq = 0.0f;
+  for (uint32_t i = 0; i < mesh.mNumVertices; i++) {
+    const auto dx = mesh.mVertices[i].x - bounds.sphere_center[0];
+    const auto dy = mesh.mVertices[i].y - bounds.sphere_center[1];
+    const auto dz = mesh.mVertices[i].z - bounds.sphere_center[2];
+    radius_sq = std::max(radius_sq, dx * dx + dy * dy + dz * dz);
+  }
+  bounds.sphere_radius = std::sqrt(radius_sq);
+  return bounds;
+}
+auto IsValidBounds(const float* aabb_min, const float* aabb_max) {
+  return aabb_min[0] <= aabb_max[0] && aabb_min[1] <= aabb_max[1] && aabb_min[2] <= aabb_max[2];
 }
-auto FindOrCreateTexture(const aiTextureType texture_type, const char* const path, std::vector<Texture>* textures) {
-  if (const auto texture_index = GetTextureIndex(texture_type, path, *textures); texture_index != kInvalidTexture) {
-    return texture_index;
+// matrix is a flattened aiMatrix4x4 (row major, translation in the 4th column)
+auto TransformBounds(const float* matrix, const MeshBoundsEntry& bounds, InstanceBoundsEntry* instance) {
+  if (!IsValidBounds(bounds.aabb_min, bounds.aabb_max)) {
+    std::copy(std::begin(bounds.aabb_min), std::end(bounds.aabb_min), instance->aabb_min);
+    std::copy(std::begin(bounds.aabb_max), std::end(bounds.aabb_max), instance->aabb_max);
+    return;
+  }
+  // arvo's method, extents of the transformed box without transforming 8 corners
+  for (uint32_t i = 0; i < 3; i++) {
+    const auto row = matrix + i * 4;
+    instance->aabb_min[i] = row[3];
+    instance->aabb_max[i] = row[3];
+    for (uint32_t j = 0; j < 3; j++) {
+      const auto a = row[j] * bounds.aabb_min[j];
+      const auto b = row[j] * bounds.aabb_max[j];
+      instance->aabb_min[i] += std::min(a, b);
+      instance->aabb_max[i] += std::max(a, b);
+    }
   }
-  const auto texture_index = GetUint32(textures->size());
-  textures->push_back(CreateTexture(texture_type, path));
-  return texture_index;
 }
-auto FindOrCreateSampler(const aiTextureMapMode mapmode[3], const uint32_t mag_filter, const uint32_t min_filter, std::vector<Sampler>* samplers) {
-  if (const auto sampler_index = GetSamplerIndex(mapmode, mag_filter, min_filter, *samplers); sampler_index != kInvalidSampler) {
-    return sampler_index;
+void CreateBoundsTables(const uint32_t thread_num,
+                        const uint32_t mesh_num,
+                        const aiMesh* const * meshes,
+                        const std::vector<float>& transform_matrix_list,
+                        const std::vector<uint32_t>& transform_index_list_offset,
+                        const std::vector<uint32_t>& transform_index_list,
+                        ContainerTables* tables) {
+  const uint32_t kMatrixComponentNum = 16;
+  tables->mesh_bounds.resize(mesh_num);
+  ParallelFor(thread_num, mesh_num, [&](const uint32_t i) {
+    tables->mesh_bounds[i] = CreateMeshBounds(*meshes[i]);
+  });
+  tables->instance_bounds.resize(transform_index_list.size());
+  for (uint32_t i = 0; i < mesh_num; i++) {
+    const auto end = (i + 1 < mesh_num) ? transform_index_list_offset[i + 1] : GetUint32(transform_index_list.size());
+    for (uint32_t j = transform_index_list_offset[i]; j < end; j++) {
+      auto& instance = tables->instance_bounds[j];
+      instance.mesh_index = i;
+      instance.transform_index = transform_index_list[j];
+      TransformBounds(&transform_matrix_list[std::size_t{instance.transform_index} * kMatrixComponentNum], tables->mesh_bounds[i], &instance);
+    }
   }
-  const auto sampler_index = GetUint32(samplers->size());
-  samplers->push_back(CreateSampler(mapmode, mag_filter, min_filter));
-  return sampler_index;
 }
-const uint32_t SamplerFilter_UNSET = 0;
-const uint32_t SamplerMagFilter_Nearest = 9728;
-const uint32_t SamplerMagFilter_Linear = 9729;
-const uint32_t SamplerMinFilter_Nearest = 9728;
-const uint32_t SamplerMinFilter_Linear = 9729;
-const uint32_t SamplerMinFilter_Nearest_Mipmap_Nearest = 9984;
-const uint32_t SamplerMinFilter_Linear_Mipmap_Nearest = 9985;
-const uint32_t SamplerMinFilter_Nearest_Mipmap_Linear = 9986;
-const uint32_t SamplerMinFilter_Linear_Mipmap_Linear = 9987;
-auto CreateDefaultMaterial(const aiTextureType texture_type, std::vector<Texture>* textures, std::vector<Sampler>* samplers) {
-  nlohmann::json texture_json;
-  switch (texture_type) {
-    case aiTextureType_UNKNOWN: // occulusion-metallic-roughness
-      texture_json["texture"] = FindOrCreateTexture(aiTextureType_UNKNOWN, "yellow", textures);
-      break;
-    case aiTextureType_BASE_COLOR:
-      texture_json["texture"] = FindOrCreateTexture(aiTextureType_BASE_COLOR, "white", textures);
-      break;
-    case aiTextureType_NORMALS:
-      texture_json["texture"] = FindOrCreateTexture(aiTextureType_NORMALS, "normal", textures);
-      break;
-    case aiTextureType_EMISSIVE:
-      texture_json["texture"] = FindOrCreateTexture(aiTextureType_EMISSIVE, "black", textures);
-      break;
+struct BvhAabb {
+  float min[3]{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+  float max[3]{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+  void Grow(const float* aabb_min, const float* aabb_max) {
+    for (uint32_t i = 0; i < 3; i++) {
+      min[i] = std::min(min[i], aabb_min[i]);
+      max[i] = std::max(max[i], aabb_max[i]);
+    }
   }
-  const aiTextureMapMode mapmode[] = {aiTextureMapMode_Wrap, aiTextureMapMode_Wrap, static_cast<aiTextureMapMode>(-1)};
-  texture_json["sampler"] = FindOrCreateSampler(mapmode, SamplerMagFilter_Linear, SamplerMinFilter_Linear_Mipmap_Linear, samplers);
-  return texture_json;
+  float GetSurfaceArea() const {
+    if (min[0] > max[0]) { return 0.0f; }
+    const float d[] = {max[0] - min[0], max[1] - min[1], max[2] - min[2]};
+    return 2.0f * (d[0] * d[1] + d[1] * d[2] + d[2] * d[0]);
+  }
+};
+const uint32_t kBvhBinNum = 16;
+const uint32_t kBvhMaxLeafInstanceNum = 4;
+auto GetCentroid(const InstanceBoundsEntry& instance, const uint32_t axis) {
+  return (instance.aabb_min[axis] + instance.aabb_max[axis]) * 0.5f;
 }
-auto GetTexture(const aiMaterial& material, const aiTextureType texture_type, std::vector<Texture>* textures, std::vector<Sampler>* samplers) {
-  if (material.GetTextureCount(texture_type) == 0) {
-    return CreateDefaultMaterial(texture_type, textures, samplers);
+// binned sah split, returns false when a leaf is cheaper
+auto FindBvhSplit(const std::vector<InstanceBoundsEntry>& instances, const uint32_t* begin, const uint32_t* end, const float node_area, uint32_t* split_axis, float* split_position) {
+  const auto count = static_cast<uint32_t>(end - begin);
+  auto best_cost = static_cast<float>(count) * node_area; // leaf cost relative to traversal
+  auto found = false;
+  for (uint32_t axis = 0; axis < 3; axis++) {
+    auto centroid_min = std::numeric_limits<float>::max();
+    auto centroid_max = std::numeric_limits<float>::lowest();
+    for (auto it = begin; it != end; it++) {
+      const auto centroid = GetCentroid(instances[*it], axis);
+      centroid_min = std::min(centroid_min, centroid);
+      centroid_max = std::max(centroid_max, centroid);
+    }
+    if (centroid_max <= centroid_min) { continue; }
+    const auto scale = static_cast<float>(kBvhBinNum) / (centroid_max - centroid_min);
+    BvhAabb bin_aabbs[kBvhBinNum];
+    uint32_t bin_counts[kBvhBinNum]{};
+    for (auto it = begin; it != end; it++) {
+      const auto& instance = instances[*it];
+      const auto bin = std::min(static_cast<uint32_t>((GetCentroid(instance, axis) - centroid_min) * scale), kBvhBinNum - 1);
+      bin_aabbs[bin].Grow(instance.aabb_min, instance.aabb_max);
+      bin_counts[bin]++;
+    }
+    // sweep from the right to get costs of all planes in one pass each way
+    float right_areas[kBvhBinNum]{};
+    uint32_t right_counts[kBvhBinNum]{};
+    BvhAabb right_aabb;
+    uint32_t right_count = 0;
+    for (uint32_t i = kBvhBinNum - 1; i > 0; i--) {
+      right_aabb.Grow(bin_aabbs[i].min, bin_aabbs[i].max);
+      right_count += bin_counts[i];
+      right_areas[i] = right_aabb.GetSurfaceArea();
+      right_counts[i] = right_count;
+    }
+    BvhAabb left_aabb;
+    uint32_t left_count = 0;
+    for (uint32_t i = 0; i < kBvhBinNum - 1; i++) {
+      left_aabb.Grow(bin_aabbs[i].min, bin_aabbs[i].max);
+      left_count += bin_counts[i];
+      if (left_count == 0 || right_counts[i + 1] == 0) { continue; }
+      const auto cost = node_area + left_aabb.GetSurfaceArea() * static_cast<float>(left_count) + right_areas[i + 1] * static_cast<float>(right_counts[i + 1]);
+      if (cost >= best_cost) { continue; }
+      best_cost = cost;
+      *split_axis = axis;
+      *split_position = centroid_min + static_cast<float>(i + 1) / scale;
+      found = true;
+    }
   }
-  if (material.GetTextureCount(texture_type) > 1) {
-    logwarn("multiple texture not implemented {}", texture_type);
-    return CreateDefaultMaterial(texture_type, textures, samplers);
+  return found;
+}
+void BuildBvhNode(const std::vector<InstanceBoundsEntry>& instances, uint32_t* const instance_indices, const uint32_t begin, const uint32_t end, std::vector<BvhNodeEntry>* nodes) {
+  BvhAabb aabb;
+  for (uint32_t i = begin; i < end; i++) {
+    aabb.Grow(instances[instance_indices[i]].aabb_min, instances[instance_indices[i]].aabb_max);
   }
-  aiString path;
-  aiTextureMapping mapping;
-  unsigned int uvindex;
-  ai_real blend;
-  aiTextureOp op;
-  aiTextureMapMode mapmode[3];
-  const uint32_t slot = 0;
-  if (const auto result = material.GetTexture(texture_type, slot, &path, &mapping, &uvindex, &blend, &op, mapmode); result != AI_SUCCESS) {
-    return CreateDefaultMaterial(texture_type, textures, samplers);
+  const auto node_index = GetUint32(nodes->size());
+  nodes->push_back(BvhNodeEntry{});
+  auto set_node = [&](const uint32_t offset, const uint32_t instance_num) {
+    auto& node = (*nodes)[node_index];
+    std::copy(std::begin(aabb.min), std::end(aabb.min), node.aabb_min);
+    std::copy(std::begin(aabb.max), std::end(aabb.max), node.aabb_max);
+    node.offset = offset;
+    node.instance_num = instance_num;
+  };
+  uint32_t split_axis = 0;
+  float split_position = 0.0f;
+  const auto count = end - begin;
+  auto split = begin;
+  if (count > kBvhMaxLeafInstanceNum) {
+    if (FindBvhSplit(instances, instance_indices + begin, instance_indices + end, aabb.GetSurfaceArea(), &split_axis, &split_position)) {
+      split = static_cast<uint32_t>(std::partition(instance_indices + begin, instance_indices + end, [&](const uint32_t i) { return GetCentroid(instances[i], split_axis) < split_position; }) - instance_indices);
+    } else {
+      // e.g. instances at the same place, median split along the longest axis keeps leaves small
+      const float extent[] = {aabb.max[0] - aabb.min[0], aabb.max[1] - aabb.min[1], aabb.max[2] - aabb.min[2]};
+      split_axis = static_cast<uint32_t>(std::max_element(std::begin(extent), std::end(extent)) - std::begin(extent));
+      split = begin + count / 2;
+      std::nth_element(instance_indices + begin, instance_indices + split, instance_indices + end, [&](const uint32_t a, const uint32_t b) { return GetCentroid(instances[a], split_axis) < GetCentroid(instances[b], split_axis); });
+    }
   }
-  if (mapping != aiTextureMapping::aiTextureMapping_UV) {
-    logerror("only uv mapping is supported {}", mapping);
-    return CreateDefaultMaterial(texture_type, textures, samplers);
+  if (split == begin || split == end) {
+    set_node(begin, count);
+    return;
   }
-  if (uvindex != 0) {
-    logerror("only uv 0 supported so far. {}", uvindex);
-    return CreateDefaultMaterial(texture_type, textures, samplers);
+  BuildBvhNode(instances, instance_indices, begin, split, nodes);
+  set_node(GetUint32(nodes->size()), 0);
+  BuildBvhNode(instances, instance_indices, split, end, nodes);
+}
+// bvh over instance bounds, leaves refer to ranges of tables->bvh_instances
+void BuildInstanceBvh(ContainerTables* tables) {
+  for (uint32_t i = 0; i < tables->instance_bounds.size(); i++) {
+    const auto& instance = tables->instance_bounds[i];
+    if (!IsValidBounds(instance.aabb_min, instance.aabb_max)) { continue; }
+    tables->bvh_instances.push_back(i);
   }
-  nlohmann::json texture_json;
-  texture_json["texture"] = FindOrCreateTexture(texture_type, path.C_Str(), textures);
-  aiUVTransform transform{};
-  if (const auto result = material.Get(AI_MATKEY_UVTRANSFORM(texture_type, slot), transform); result == AI_SUCCESS) {
-    // not needed so far.
+  if (tables->bvh_instances.empty()) { return; }
+  BuildBvhNode(tables->instance_bounds, tables->bvh_instances.data(), 0, GetUint32(tables->bvh_instances.size()), &tables->bvh_nodes);
+}
+auto GetTextureRef(const nlohmann::json& texture_json) {
+  return TextureRef{
+    .texture_index = texture_json["texture"].get<uint32_t>(),
+    .sampler_index = texture_json["sampler"].get<uint32_t>(),
+  };
+}
+template <std::size_t N>
+void CopyFactor(const nlohmann::json& json, float (&dst)[N]) {
+  for (std::size_t i = 0; i < N && i < json.size(); i++) {
+    dst[i] = json[i].get<float>();
   }
-  uint32_t mag_filter{SamplerMagFilter_Linear};
-  uint32_t min_filter{SamplerMinFilter_Linear_Mipmap_Linear};
-  material.Get(AI_MATKEY_GLTF_MAPPINGFILTER_MAG(texture_type, slot), mag_filter);
-  material.Get(AI_MATKEY_GLTF_MAPPINGFILTER_MIN(texture_type, slot), min_filter);
-  texture_json["sampler"] = FindOrCreateSampler(mapmode, mag_filter, min_filter, samplers);
-  return texture_json;
 }
-std::string GetMapMode(const aiTextureMapMode mapmode) {
-  switch (mapmode) {
-    case aiTextureMapMode_Wrap:
-      return "wrap";
-    case aiTextureMapMode_Clamp:
-      return "clamp";
-    case aiTextureMapMode_Decal:
-      logwarn("aiTextureMapMode_Decal not implemented");
-      return "wrap";
-    case aiTextureMapMode_Mirror:
-      return "mirror";
+auto GetTextureType(const std::string& type) {
+  if (type == "albedo") { return TextureType::kAlbedo; }
+  if (type == "normal") { return TextureType::kNormal; }
+  if (type == "emissive") { return TextureType::kEmissive; }
+  return TextureType::kOcclusionMetallicRoughness;
+}
+auto GetTextureAddressMode(const std::string& mapmode) {
+  if (mapmode == "wrap") { return TextureAddressMode::kWrap; }
+  if (mapmode == "clamp") { return TextureAddressMode::kClamp; }
+  if (mapmode == "mirror") { return TextureAddressMode::kMirror; }
+  return TextureAddressMode::kUnset;
+}
+auto GetTextureFilter(const std::string& filter) {
+  return filter == "point" ? TextureFilter::kPoint : TextureFilter::kLinear;
+}
+auto GetAlphaMode(const std::string& alpha_mode) {
+  if (alpha_mode == "MASK") { return AlphaMode::kMask; }
+  if (alpha_mode == "BLEND") { return AlphaMode::kBlend; }
+  return AlphaMode::kOpaque;
+}
+void CreateMaterialTables(const nlohmann::json& material_settings, ContainerTables* tables) {
+  for (const auto& material : material_settings["materials"]) {
+    MaterialEntry entry{};
+    entry.albedo_texture = GetTextureRef(material["albedo"]["texture"]);
+    CopyFactor(material["albedo"]["factor"], entry.albedo_factor);
+    const auto& metallic_roughness_occlusion = material["metallic_roughness_occlusion"];
+    entry.occlusion_metallic_roughness_texture = GetTextureRef(metallic_roughness_occlusion["texture"]);
+    entry.occlusion_strength = metallic_roughness_occlusion["occlusion_strength"].get<float>();
+    entry.metallic_factor = metallic_roughness_occlusion["metallic_factor"].get<float>();
+    entry.roughness_factor = metallic_roughness_occlusion["roughness_factor"].get<float>();
+    entry.normal_texture = GetTextureRef(material["normal"]["texture"]);
+    entry.normal_scale = material["normal"]["scale"].get<float>();
+    entry.emissive_texture = GetTextureRef(material["emissive"]["texture"]);
+    CopyFactor(material["emissive"]["factor"], entry.emissive_factor);
+    entry.double_sided = material["double_sided"].get<bool>() ? 1 : 0;
+    entry.alpha_mode = GetAlphaMode(material["alpha_mode"].get<std::string>());
+    entry.alpha_cutoff = material["alpha_cutoff"].get<float>();
+    tables->materials.push_back(entry);
+  }
+  for (const auto& texture : material_settings["textures"]) {
+    const auto path = texture["path"].get<std::string>();
+    tables->textures.push_back(TextureEntry{
+        .type = GetTextureType(texture["type"].get<std::string>()),
+        .path_offset = GetUint32(tables->strings.size()),
+        .path_len = GetUint32(path.size()),
+        .reserved = 0,
+      });
+    tables->strings.insert(tables->strings.end(), path.begin(), path.end());
+  }
+  for (const auto& sampler : material_settings["samplers"]) {
+    SamplerEntry entry{};
+    const auto& mapmode = sampler["mapmode"];
+    for (std::size_t i = 0; i < std::size(entry.address_mode); i++) {
+      entry.address_mode[i] = i < mapmode.size() ? GetTextureAddressMode(mapmode[i].get<std::string>()) : TextureAddressMode::kUnset;
+    }
+    entry.mag_filter = GetTextureFilter(sampler["mag_filter"].get<std::string>());
+    entry.min_filter = GetTextureFilter(sampler["min_filter"].get<std::string>());
+    entry.mip_filter = GetTextureFilter(sampler["mip_filter"].get<std::string>());
+    tables->samplers.push_back(entry);
+  }
+}
+auto SliceBinaryStream(const BinaryStream& stream, const std::size_t offset_in_bytes, const std::size_t size_in_bytes, const uint32_t mesh_index) {
+  auto slice = stream;
+  // streamed sections have no buffer, see OutputContainerStreaming
+  slice.buffer = stream.buffer == nullptr ? nullptr : static_cast<const uint8_t*>(stream.buffer) + offset_in_bytes;
+  slice.size_in_bytes = size_in_bytes;
+  slice.mesh_index = mesh_index;
+  return slice;
+}
+auto GetMeshIndexDataSizeInBytes(const PerDrawCallModelIndexSet& mesh) {
+  // lod0 and lods of a mesh are contiguous, see CreateIndexStream
+  auto end = mesh.index_buffer_offset_in_bytes + uint64_t{mesh.index_buffer_len} * mesh.index_stride_in_bytes;
+  for (const auto& lod : mesh.lods) {
+    end = std::max(end, lod.index_buffer_offset_in_bytes + uint64_t{lod.index_buffer_len} * mesh.index_stride_in_bytes);
+  }
+  return end - mesh.index_buffer_offset_in_bytes;
+}
+void RebaseOffsetsToMeshSections(std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
+  for (auto& mesh : *per_draw_call_model_index_set) {
+    const auto base = mesh.index_buffer_offset_in_bytes;
+    mesh.index_buffer_offset_in_bytes -= base;
+    for (auto& lod : mesh.lods) {
+      lod.index_buffer_offset_in_bytes -= base;
+    }
+    mesh.vertex_buffer_index_offset = 0;
+  }
+}
+auto GetContainerHeaderSizeInBytes(const std::vector<BinaryStream>& sections) {
+  return uint64_t{sizeof(ContainerHeader) + sizeof(SectionEntry) * sections.size()};
+}
+// size of the section, or of all sections of the mesh starting from it when grouped per mesh
+auto GetSectionGroupSizeInBytes(const std::vector<BinaryStream>& sections, const std::size_t first) {
+  uint64_t size_in_bytes = sections[first].size_in_bytes;
+  for (auto i = first + 1; i < sections.size(); i++) {
+    if (sections[first].mesh_index == kInvalidIndex || sections[i].mesh_index != sections[first].mesh_index) { break; }
+    size_in_bytes = AlignUp(size_in_bytes, kMinSectionAlignment) + sections[i].size_in_bytes;
+  }
+  return size_in_bytes;
+}
+// with chunk_size_in_bytes, a section (or sections of a mesh) not fitting in the rest of a chunk starts a new chunk.
+// one larger than a chunk is placed alone in a chunk.
+void LayoutSections(const uint32_t section_alignment, const uint64_t chunk_size_in_bytes, std::vector<BinaryStream>* sections) {
+  const auto header_size_in_bytes = GetContainerHeaderSizeInBytes(*sections);
+  uint64_t offset_in_bytes = header_size_in_bytes;
+  uint32_t chunk_index = 0;
+  uint32_t prev_mesh_index = kInvalidIndex;
+  for (std::size_t i = 0; i < sections->size(); i++) {
+    auto& section = (*sections)[i];
+    // streams of the same mesh are read at once, only the first one needs the full alignment
+    const auto same_mesh = section.mesh_index != kInvalidIndex && section.mesh_index == prev_mesh_index;
+    auto aligned_offset_in_bytes = AlignUp(offset_in_bytes, same_mesh ? kMinSectionAlignment : section_alignment);
+    const auto chunk_start_in_bytes = chunk_index == 0 ? header_size_in_bytes : 0;
+    if (chunk_size_in_bytes > 0 && !same_mesh && offset_in_bytes > chunk_start_in_bytes
+        && aligned_offset_in_bytes + GetSectionGroupSizeInBytes(*sections, i) > chunk_size_in_bytes) {
+      chunk_index++;
+      offset_in_bytes = 0;
+      aligned_offset_in_bytes = 0;
+    }
+    section.chunk_index = chunk_index;
+    section.padding_in_bytes = GetUint32(aligned_offset_in_bytes - offset_in_bytes);
+    section.offset_in_bytes = aligned_offset_in_bytes;
+    offset_in_bytes = aligned_offset_in_bytes + section.size_in_bytes;
+    prev_mesh_index = section.mesh_index;
+  }
+}
+void SetMeshDataRanges(const std::vector<BinaryStream>& sections, std::vector<MeshEntry>* meshes) {
+  for (const auto& section : sections) {
+    if (section.mesh_index == kInvalidIndex) { continue; }
+    auto& mesh = (*meshes)[section.mesh_index];
+    if (mesh.data_size_in_bytes == 0) {
+      mesh.data_offset_in_bytes = section.offset_in_bytes;
+    }
+    mesh.data_size_in_bytes = section.offset_in_bytes + section.size_in_bytes - mesh.data_offset_in_bytes;
+  }
+}
+// section order in file follows this list, offsets and section table are derived from it
+auto CreateSectionList(const uint32_t section_alignment,
+                       const uint64_t chunk_size_in_bytes,
+                       const bool group_streams_per_mesh,
+                       const std::vector<float>& transform_matrix_list,
+                       const std::vector<uint32_t>& transform_index_list_offset,
+                       const std::vector<uint32_t>& transform_index_list,
+                       const BinaryStream& index_stream,
+                       const std::vector<BinaryStream>& vertex_streams,
+                       const MeshletBuffers& meshlet_buffers,
+                       const nlohmann::json& material_settings,
+                       std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set,
+                       ContainerTables* tables) {
+  std::vector<BinaryStream> sections;
+  sections.push_back(CreateBinaryStream(SectionType::kTransformOffset, transform_index_list_offset, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kTransformIndex, transform_index_list, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kTransform, transform_matrix_list, 16));
+  auto streams = vertex_streams;
+  for (auto& stream : streams) {
+    if (stream.attributes.size() <= 1) { continue; }
+    stream.attribute_offset = GetUint32(tables->vertex_attributes.size());
+    for (const auto& attribute : stream.attributes) {
+      tables->vertex_attributes.push_back(VertexAttributeEntry{
+          .semantic = attribute.semantic,
+          .format = attribute.format,
+          .component_num = attribute.component_num,
+          .offset_in_bytes = attribute.offset_in_bytes,
+          .encoding = attribute.encoding,
+        });
+    }
+  }
+  if (group_streams_per_mesh) {
+    const auto mesh_num = GetUint32(per_draw_call_model_index_set->size());
+    for (uint32_t i = 0; i < mesh_num; i++) {
+      const auto& mesh = (*per_draw_call_model_index_set)[i];
+      if (mesh.index_buffer_len == 0) { continue; }
+      sections.push_back(SliceBinaryStream(index_stream, mesh.index_buffer_offset_in_bytes, GetMeshIndexDataSizeInBytes(mesh), i));
+      for (const auto& stream : streams) {
+        if (stream.size_in_bytes == 0) { continue; }
+        sections.push_back(SliceBinaryStream(stream, std::size_t{mesh.vertex_buffer_index_offset} * stream.stride_in_bytes, std::size_t{mesh.vertex_num} * stream.stride_in_bytes, i));
+      }
+    }
+    RebaseOffsetsToMeshSections(per_draw_call_model_index_set);
+  } else {
+    sections.push_back(index_stream);
+    sections.insert(sections.end(), streams.begin(), streams.end());
+  }
+  sections.push_back(CreateBinaryStream(SectionType::kMeshlet, meshlet_buffers.meshlet, kMeshletComponentNum));
+  sections.push_back(CreateBinaryStream(SectionType::kMeshletVertices, meshlet_buffers.meshlet_vertices, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kMeshletTriangles, meshlet_buffers.meshlet_triangles, 3));
+  sections.push_back(CreateBinaryStream(SectionType::kMeshletBounds, meshlet_buffers.meshlet_bounds, kMeshletBoundsComponentNum));
+  CreateMeshTable(*per_draw_call_model_index_set, tables);
+  CreateMaterialTables(material_settings, tables);
+  sections.push_back(CreateBinaryStream(SectionType::kMesh, tables->meshes, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kLod, tables->lods, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kMaterial, tables->materials, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kTexture, tables->textures, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kSampler, tables->samplers, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kString, tables->strings, 1, ComponentFormat::kUint8));
+  sections.push_back(CreateBinaryStream(SectionType::kVertexAttribute, tables->vertex_attributes, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kMeshBounds, tables->mesh_bounds, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kInstanceBounds, tables->instance_bounds, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kBvhNode, tables->bvh_nodes, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kBvhInstance, tables->bvh_instances, 1));
+  LayoutSections(section_alignment, chunk_size_in_bytes, &sections);
+  SetMeshDataRanges(sections, &tables->meshes);
+  return sections;
+}
+auto IsValidSectionAlignment(const uint32_t section_alignment) {
+  return section_alignment >= kMinSectionAlignment && (section_alignment & (section_alignment - 1)) == 0;
+}
+auto CreateSectionEntry(const BinaryStream& section) {
+  SectionEntry entry{};
+  entry.type = section.type;
+  entry.stride_in_bytes = section.stride_in_bytes;
+  entry.offset_in_bytes = section.offset_in_bytes;
+  entry.size_in_bytes = section.size_in_bytes;
+  entry.padding_in_bytes = section.padding_in_bytes;
+  entry.mesh_index = section.mesh_index;
+  entry.chunk_index = section.chunk_index;
+  if (section.attributes.size() == 1) {
+    entry.format = section.attributes[0].format;
+    entry.component_num = section.attributes[0].component_num;
+    entry.encoding = section.attributes[0].encoding;
+  } else {
+    entry.format = ComponentFormat::kInterleaved;
+    entry.attribute_offset = section.attribute_offset;
+    entry.attribute_num = GetUint32(section.attributes.size());
+  }
+  return entry;
+}
+auto OutputBinaryToFile(const size_t file_size_in_byte, const void* buffer, std::ostream* ostream) {
+  ostream->write(reinterpret_cast<const char*>(buffer), static_cast<std::streamsize>(file_size_in_byte));
+}
+auto GetChunkNum(const std::vector<BinaryStream>& sections) {
+  return sections.empty() ? 1U : sections.back().chunk_index + 1;
+}
+auto GetChunkSizeInBytes(const std::vector<BinaryStream>& sections, const uint32_t chunk_index) {
+  auto size_in_bytes = chunk_index == 0 ? GetContainerHeaderSizeInBytes(sections) : uint64_t{0};
+  for (const auto& section : sections) {
+    if (section.chunk_index != chunk_index) { continue; }
+    size_in_bytes = std::max(size_in_bytes, section.offset_in_bytes + section.size_in_bytes);
+  }
+  return size_in_bytes;
+}
+// <name>.bin for chunk 0, <name>.<chunk_index>.bin for the others
+auto GetChunkFilename(const char* const filename, const uint32_t chunk_index) {
+  if (chunk_index == 0) { return std::string(filename); }
+  return std::filesystem::path(filename).replace_extension(fmt::format(".{}.bin", chunk_index)).generic_string();
+}
+// zero filled files of the final size per chunk, sections are written to their offsets afterwards
+auto CreateContainerFile(const std::vector<BinaryStream>& sections, const char* const filename) {
+  std::vector<std::fstream> chunk_files;
+  for (uint32_t i = 0; i < GetChunkNum(sections); i++) {
+    const auto chunk_filename = GetChunkFilename(filename, i);
+    {
+      std::ofstream create_file(chunk_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+    std::filesystem::resize_file(chunk_filename, GetChunkSizeInBytes(sections, i));
+    chunk_files.emplace_back(chunk_filename, std::ios::in | std::ios::out | std::ios::binary);
+  }
+  return chunk_files;
+}
+auto WriteToFileAt(const uint64_t offset_in_bytes, const std::size_t size_in_bytes, const void* buffer, std::ostream* ostream) {
+  ostream->seekp(static_cast<std::streamoff>(offset_in_bytes));
+  OutputBinaryToFile(size_in_bytes, buffer, ostream);
+}
+auto CreateContainerHeader(const uint32_t section_alignment, const std::vector<BinaryStream>& sections) {
+  return ContainerHeader{
+    .magic = kContainerMagic,
+    .version = kContainerVersion,
+    .section_num = GetUint32(sections.size()),
+    .header_size_in_bytes = GetUint32(sizeof(ContainerHeader)),
+    .section_table_offset_in_bytes = sizeof(ContainerHeader),
+    .file_size_in_bytes = GetChunkSizeInBytes(sections, 0),
+    .section_alignment = section_alignment,
+    .chunk_num = GetChunkNum(sections),
+  };
+}
+// header, section table and sections with a buffer
+void WriteSectionsToFile(const uint32_t section_alignment, const std::vector<BinaryStream>& sections, std::vector<std::fstream>* chunk_files) {
+  const auto header = CreateContainerHeader(section_alignment, sections);
+  auto& file = (*chunk_files)[0];
+  WriteToFileAt(0, sizeof(header), &header, &file);
+  for (const auto& section : sections) {
+    const auto entry = CreateSectionEntry(section);
+    OutputBinaryToFile(sizeof(entry), &entry, &file);
+  }
+  for (const auto& section : sections) {
+    if (section.buffer == nullptr || section.size_in_bytes == 0) { continue; }
+    WriteToFileAt(section.offset_in_bytes, section.size_in_bytes, section.buffer, &(*chunk_files)[section.chunk_index]);
+  }
+}
+void OutputContainerToFile(const uint32_t section_alignment, const std::vector<BinaryStream>& sections, const char* const filename) {
+  auto output_file = CreateContainerFile(sections, filename);
+  WriteSectionsToFile(section_alignment, sections, &output_file);
+}
+// same layout as the file, padding is zero filled by resize. sections must be in a single chunk.
+void OutputContainerToMemory(const uint32_t section_alignment, const std::vector<BinaryStream>& sections, std::vector<uint8_t>* container) {
+  assert(GetChunkNum(sections) == 1);
+  container->resize(GetChunkSizeInBytes(sections, 0));
+  const auto header = CreateContainerHeader(section_alignment, sections);
+  memcpy(container->data(), &header, sizeof(header));
+  auto section_table = container->data() + header.section_table_offset_in_bytes;
+  for (const auto& section : sections) {
+    const auto entry = CreateSectionEntry(section);
+    memcpy(section_table, &entry, sizeof(entry));
+    section_table += sizeof(entry);
+  }
+  for (const auto& section : sections) {
+    if (section.buffer == nullptr || section.size_in_bytes == 0) { continue; }
+    memcpy(container->data() + section.offset_in_bytes, section.buffer, section.size_in_bytes);
   }
+}
+auto CreateVertexStreamLayout(const Options& options) {
+  // streams of a single dummy vertex, only formats and strides are used
+  MeshBuffers mesh_buffers;
+  ResizeMeshBuffers(0, 1, &mesh_buffers);
+  mesh_buffers.vertex_buffer_normal = {0.0f, 0.0f, 1.0f};
+  mesh_buffers.vertex_buffer_tangent = {1.0f, 0.0f, 0.0f};
+  std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set(1);
+  per_draw_call_model_index_set[0].vertex_num = 1;
+  QuantizedMeshBuffers quantized_mesh_buffers;
+  if (options.quantize_vertex) {
+    quantized_mesh_buffers = QuantizeMeshBuffers(options.quantize_position, options.texcoord_unorm16, mesh_buffers, &per_draw_call_model_index_set);
+  }
+  std::vector<uint8_t> interleaved_vertex_buffer;
+  auto streams = CreateVertexStreams(options.vertex_layout, CreateSeparateVertexStreams(mesh_buffers, options.quantize_vertex ? &quantized_mesh_buffers : nullptr), &interleaved_vertex_buffer);
+  for (auto& stream : streams) {
+    stream.buffer = nullptr;
+    stream.size_in_bytes = 0;
+  }
+  return streams;
+}
+// writes each mesh straight to its final offset instead of gathering whole scene buffers.
+// memory in use besides the scene is bounded by the largest meshes in flight (one per thread).
+auto OutputContainerStreaming(const aiScene& scene,
+                              const Options& options,
+                              const std::vector<float>& transform_matrix_list,
+                              const std::vector<uint32_t>& transform_index_list_offset,
+                              const std::vector<uint32_t>& transform_index_list,
+                              const nlohmann::json& material_settings,
+                              std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set,
+                              ContainerTables* tables,
+                              const char* const filename,
+                              ConversionMetrics* metrics) {
+  if (!options.lod_target_ratios.empty() || options.build_meshlets) {
+    logwarn("lods and meshlets are not generated in streaming write");
+  }
+  const auto mesh_num = scene.mNumMeshes;
+  const auto layout_start = std::chrono::steady_clock::now();
+  const auto [index_buffer_len, vertex_num] = AssignMeshOffsets(mesh_num, scene.mMeshes, per_draw_call_model_index_set);
+  // same layout as CreateIndexStream with contiguous_per_mesh
+  uint64_t index_buffer_size_in_bytes = 0;
+  uint32_t uint16_mesh_num = 0, uint32_mesh_num = 0;
+  for (auto& mesh : *per_draw_call_model_index_set) {
+    if (mesh.index_buffer_len == 0) { continue; }
+    mesh.index_stride_in_bytes = GetIndexStrideInBytes(options.narrow_index_buffer, mesh.vertex_num);
+    mesh.index_buffer_offset_in_bytes = index_buffer_size_in_bytes;
+    index_buffer_size_in_bytes = AlignUp(index_buffer_size_in_bytes + uint64_t{mesh.index_buffer_len} * mesh.index_stride_in_bytes, kIndexBufferAlignment);
+    if (mesh.index_stride_in_bytes == sizeof(uint16_t)) {
+      uint16_mesh_num++;
+    } else {
+      uint32_mesh_num++;
+    }
+  }
+  auto index_stream = CreateIndexStreamFromBuffer(std::vector<uint8_t>{}, uint16_mesh_num, uint32_mesh_num);
+  index_stream.buffer = nullptr;
+  index_stream.size_in_bytes = index_buffer_size_in_bytes;
+  auto vertex_streams = CreateVertexStreamLayout(options);
+  for (auto& stream : vertex_streams) {
+    stream.size_in_bytes = std::size_t{vertex_num} * stream.stride_in_bytes;
+  }
+  logdebug("streaming write indices:{} vertices:{}", index_buffer_len, vertex_num);
+  const auto mesh_layout = *per_draw_call_model_index_set; // absolute offsets before rebased to grouped sections
+  const auto sections = CreateSectionList(options.section_alignment, options.chunk_size_in_bytes, options.group_streams_per_mesh, transform_matrix_list, transform_index_list_offset, transform_index_list, index_stream, vertex_streams, MeshletBuffers{}, material_settings, per_draw_call_model_index_set, tables);
+  // chunk file offsets of index and vertex streams per mesh
+  std::vector<uint64_t> stream_offset_list(std::size_t{mesh_num} * (vertex_streams.size() + 1));
+  std::vector<uint32_t> stream_chunk_list(stream_offset_list.size());
+  if (options.group_streams_per_mesh) {
+    for (uint32_t i = 0; i < sections.size(); i++) {
+      const auto mesh_index = sections[i].mesh_index;
+      if (mesh_index == kInvalidIndex || (i > 0 && sections[i - 1].mesh_index == mesh_index)) { continue; }
+      for (std::size_t j = 0; j <= vertex_streams.size(); j++) {
+        stream_offset_list[mesh_index * (vertex_streams.size() + 1) + j] = sections[i + j].offset_in_bytes;
+        stream_chunk_list[mesh_index * (vertex_streams.size() + 1) + j] = sections[i + j].chunk_index;
+      }
+    }
+  } else {
+    const auto index_section = std::find_if(sections.begin(), sections.end(), [](const BinaryStream& section) { return section.type == SectionType::kIndex; });
+    for (uint32_t i = 0; i < mesh_num; i++) {
+      const auto& mesh = mesh_layout[i];
+      auto offset_list = &stream_offset_list[i * (vertex_streams.size() + 1)];
+      auto chunk_list = &stream_chunk_list[i * (vertex_streams.size() + 1)];
+      offset_list[0] = index_section->offset_in_bytes + mesh.index_buffer_offset_in_bytes;
+      chunk_list[0] = index_section->chunk_index;
+      for (std::size_t j = 0; j < vertex_streams.size(); j++) {
+        const auto& stream = index_section[static_cast<std::ptrdiff_t>(j + 1)];
+        offset_list[j + 1] = stream.offset_in_bytes + std::size_t{mesh.vertex_buffer_index_offset} * stream.stride_in_bytes;
+        chunk_list[j + 1] = stream.chunk_index;
+      }
+    }
+  }
+  RecordStage("layout", layout_start, metrics);
+  // meshes are gathered, processed and written in one pass
+  MeasureStage("gather and write", metrics, [&]() {
+    auto chunk_files = CreateContainerFile(sections, filename);
+    std::mutex output_file_mutex;
+    ParallelFor(options.thread_num, mesh_num, [&](const uint32_t i) {
+      const auto& layout = mesh_layout[i];
+      if (layout.index_buffer_len == 0) { return; }
+      std::vector<PerDrawCallModelIndexSet> local_mesh(1);
+      local_mesh[0].index_buffer_len = layout.index_buffer_len;
+      local_mesh[0].vertex_num = layout.vertex_num;
+      MeshBuffers mesh_buffers;
+      ResizeMeshBuffers(layout.index_buffer_len, layout.vertex_num, &mesh_buffers);
+      FillMeshData(*scene.mMeshes[i], local_mesh[0], &mesh_buffers);
+      if (options.optimize_mesh) {
+        OptimizeMesh(local_mesh[0], &mesh_buffers);
+      }
+      QuantizedMeshBuffers quantized_mesh_buffers;
+      if (options.quantize_vertex) {
+        quantized_mesh_buffers = QuantizeMeshBuffers(options.quantize_position, options.texcoord_unorm16, mesh_buffers, &local_mesh);
+        CopyDequantizeParams(local_mesh[0], &(*per_draw_call_model_index_set)[i]);
+        CopyDequantizeParams(local_mesh[0], &tables->meshes[i]);
+      }
+      std::vector<uint8_t> index_buffer;
+      AppendIndices(mesh_buffers.index_buffer.data(), layout.index_buffer_len, layout.index_stride_in_bytes, &index_buffer);
+      std::vector<uint8_t> interleaved_vertex_buffer;
+      const auto streams = CreateVertexStreams(options.vertex_layout, CreateSeparateVertexStreams(mesh_buffers, options.quantize_vertex ? &quantized_mesh_buffers : nullptr), &interleaved_vertex_buffer);
+      const auto offset_list = &stream_offset_list[i * (vertex_streams.size() + 1)];
+      const auto chunk_list = &stream_chunk_list[i * (vertex_streams.size() + 1)];
+      std::lock_guard<std::mutex> lock(output_file_mutex);
+      WriteToFileAt(offset_list[0], index_buffer.size(), index_buffer.data(), &chunk_files[chunk_list[0]]);
+      for (std::size_t j = 0; j < streams.size(); j++) {
+        WriteToFileAt(offset_list[j + 1], streams[j].size_in_bytes, streams[j].buffer, &chunk_files[chunk_list[j + 1]]);
+      }
+    });
+    WriteSectionsToFile(options.section_alignment, sections, &chunk_files);
+  });
+  return sections;
+}
+auto CreateJsonBinaryEntity(const std::size_t& size_in_bytes, const std::size_t& stride_in_bytes, const uint64_t offset_in_bytes, const char* const format, const uint32_t component_num) {
+  nlohmann::json json;
+  json["size_in_bytes"] = size_in_bytes;
+  json["stride_in_bytes"] = stride_in_bytes;
+  json["offset_in_bytes"] = offset_in_bytes;
+  json["format"] = format;
+  json["component_num"] = component_num;
+  return json;
+}
+auto CreateJsonBinaryEntity(const BinaryStream& stream) {
+  if (stream.attributes.size() == 1) {
+    const auto& attribute = stream.attributes[0];
+    auto json = CreateJsonBinaryEntity(stream.size_in_bytes, stream.size_in_bytes == 0 ? 0 : stream.stride_in_bytes, stream.offset_in_bytes, GetComponentFormatName(attribute.format), attribute.component_num);
+    json["padding_in_bytes"] = stream.padding_in_bytes;
+    json["chunk_index"] = stream.chunk_index;
+    if (const auto encoding = GetAttributeEncodingName(attribute.encoding); encoding != nullptr) {
+      json["encoding"] = encoding;
+    }
+    return json;
+  }
+  nlohmann::json json;
+  json["size_in_bytes"] = stream.size_in_bytes;
+  json["stride_in_bytes"] = stream.stride_in_bytes;
+  json["offset_in_bytes"] = stream.offset_in_bytes;
+  json["padding_in_bytes"] = stream.padding_in_bytes;
+  json["chunk_index"] = stream.chunk_index;
+  json["format"] = GetComponentFormatName(ComponentFormat::kInterleaved);
+  for (const auto& attribute : stream.attributes) {
+    auto& attribute_json = json["attributes"][GetSectionName(attribute.semantic)];
+    attribute_json["offset_in_bytes"] = attribute.offset_in_bytes;
+    attribute_json["format"] = GetComponentFormatName(attribute.format);
+    attribute_json["component_num"] = attribute.component_num;
+    if (const auto encoding = GetAttributeEncodingName(attribute.encoding); encoding != nullptr) {
+      attribute_json["encoding"] = encoding;
+    }
+  }
+  return json;
+}
+auto CreateLodJson(const uint64_t index_buffer_offset_in_bytes, const uint32_t index_buffer_len, const float error, const uint32_t index_stride_in_bytes) {
+  nlohmann::json json;
+  json["index_buffer_offset"] = index_buffer_offset_in_bytes / index_stride_in_bytes;
+  json["index_buffer_offset_in_bytes"] = index_buffer_offset_in_bytes;
+  json["index_buffer_len"] = index_buffer_len;
+  json["error"] = error;
+  return json;
+}
+auto CreateMeshJson(const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set) {
+  auto json = nlohmann::json::array();
+  const auto mesh_num = per_draw_call_model_index_set.size();
+  for (uint32_t i = 0; i < mesh_num; i++) {
+    const auto& mesh = per_draw_call_model_index_set[i];
+    nlohmann::json elem;
+    elem["instance_num"] = mesh.transform_matrix_index_list.size();
+    elem["index_format"] = mesh.index_stride_in_bytes == sizeof(uint16_t) ? "uint16" : "uint32";
+    elem["index_buffer_offset"] = mesh.index_buffer_offset_in_bytes / mesh.index_stride_in_bytes; // in elements of index_format
+    elem["index_buffer_offset_in_bytes"] = mesh.index_buffer_offset_in_bytes;
+    elem["index_buffer_len"] = mesh.index_buffer_len;
+    elem["vertex_buffer_index_offset"] = mesh.vertex_buffer_index_offset;
+    elem["vertex_num"] = mesh.vertex_num;
+    elem["material_index"] = mesh.material_index;
+    elem["meshlet_offset"] = mesh.meshlet_offset;
+    elem["meshlet_num"] = mesh.meshlet_num;
+    auto lods = nlohmann::json::array();
+    lods.push_back(CreateLodJson(mesh.index_buffer_offset_in_bytes, mesh.index_buffer_len, 0.0f, mesh.index_stride_in_bytes));
+    for (const auto& lod : mesh.lods) {
+      lods.push_back(CreateLodJson(lod.index_buffer_offset_in_bytes, lod.index_buffer_len, lod.error, mesh.index_stride_in_bytes));
+    }
+    elem["lods"] = std::move(lods);
+    elem["position_dequantize"] = {{"offset", mesh.position_offset}, {"scale", mesh.position_scale}};
+    elem["texcoord_dequantize"] = {{"offset", mesh.texcoord_offset}, {"scale", mesh.texcoord_scale}};
+    json.emplace_back(std::move(elem));
+  }
+  return json;
+}
+auto CreateJsonBinaryEntityList(const uint32_t section_alignment, const std::vector<BinaryStream>& sections) {
+  nlohmann::json json;
+  json["section_alignment"] = section_alignment;
+  json["chunk_num"] = GetChunkNum(sections);
+  for (const auto& section : sections) {
+    if (section.mesh_index != kInvalidIndex) {
+      json["mesh_sections"][section.mesh_index][GetSectionName(section.type)] = CreateJsonBinaryEntity(section);
+      continue;
+    }
+    json[GetSectionName(section.type)] = CreateJsonBinaryEntity(section);
+  }
+  return json;
+}
+void WriteOutJson(const nlohmann::json& json, const char* const filename) {
+  std::ofstream output_stream(filename);
+  output_stream << std::setw(2) << json << std::endl;
+}
+auto GetFilenameStem(const char* const filename) {
+  std::string str(filename);
+  auto slash_pos = str.find_last_of('/');
+  auto period_pos = str.find_last_of('.');
+  if (slash_pos == std::string::npos) {
+    slash_pos = 0;
+  } else {
+    slash_pos++;
+    if (slash_pos >= str.length()) {
+      logerror("invalid filename {} {}", str.c_str(), slash_pos);
+      slash_pos = str.length() - 1;
+    }
+  }
+  if (period_pos == std::string::npos) {
+    period_pos = str.length();
+  }
+  return str.substr(slash_pos, period_pos - slash_pos);
+}
+auto MergeStrings(const char* const str1, const char str2, const char* const str3) {
+  const uint32_t kBufferLen = 128;
+  char buffer[kBufferLen];
+  const auto result = snprintf(buffer, kBufferLen, "%s%c%s", str1, str2, str3);
+  if (result > 0 && result < kBufferLen) {
+    return std::string(buffer);
+  }
+  logerror("snprintf error:{} {} {} {}", result, str1, str2, str3);
   return std::string();
 }
-std::string GetMagFilter(const uint32_t mag_filter) {
-  switch (mag_filter) {
-    case SamplerFilter_UNSET:
-      return "linear";
-    case SamplerMagFilter_Nearest:
-      return "point";
-    case SamplerMagFilter_Linear:
-      return "linear";
+auto GetOutputFilename(const char* const basename, const char* const extension) {
+  return MergeStrings(basename, '.', extension);
+}
+auto GetOutputFilePath(const char* const directory, const char* const filename) {
+  return MergeStrings(directory, '/', filename);
+}
+auto GetShadingMode(const aiMaterial& material) {
+  int32_t shading_mode;
+  if (const auto result = material.Get(AI_MATKEY_SHADING_MODEL, shading_mode); result != AI_SUCCESS) {
+    logerror("failed to retrieve AI_MATKEY_SHADING_MODEL {}", result);
+    return 0;
   }
-  logerror("invalid value for mag filter {}", mag_filter);
-  return "linear";
+  return shading_mode;
 }
-std::string GetMinFilter(const uint32_t min_filter) {
-  switch (min_filter) {
-    case SamplerFilter_UNSET:
-      return "linear";
-    case SamplerMinFilter_Nearest:
-      return "point";
-    case SamplerMinFilter_Linear:
-      return "linear";
-    case SamplerMinFilter_Nearest_Mipmap_Nearest:
-      return "point";
-    case SamplerMinFilter_Linear_Mipmap_Nearest:
-      return "linear";
-    case SamplerMinFilter_Nearest_Mipmap_Linear:
-      return "point";
-    case SamplerMinFilter_Linear_Mipmap_Linear:
-      return "linear";
+auto GetMaterialVal(const aiMaterial& material, const char * const key, const uint32_t type, const uint32_t idx, std::vector<float>&& default_val) {
+  aiColor4D color;
+  if (const auto result = material.Get(key, type, idx, color); result != AI_SUCCESS) {
+    logwarn("material: failed to get {} {} {} {}", key, type, idx, result);
+    return default_val;
+  }
+  return std::vector{color.r, color.g, color.b, color.a};
+}
+auto GetMaterialVal(const aiMaterial& material, const char * const key, const uint32_t type, const uint32_t idx, const float default_val) {
+  float val{default_val};
+  if (const auto result = material.Get(key, type, idx, val); result != AI_SUCCESS) {
+    logwarn("material: failed to get {} {} {} {}", key, type, idx, result);
+  }
+  return val;
+}
+auto GetMaterialVal(const aiMaterial& material, const char * const key, const uint32_t type, const uint32_t idx, const bool default_val) {
+  bool val{default_val};
+  if (const auto result = material.Get(key, type, idx, val); result != AI_SUCCESS) {
+    logwarn("material: failed to get {} {} {} {}", key, type, idx, result);
+  }
+  return val;
+}
+auto GetMaterialStrVal(const aiMaterial& material, const char * const key, const uint32_t type, const uint32_t idx, std::string&& default_val) {
+  aiString val;
+  if (const auto result = material.Get(key, type, idx, val); result != AI_SUCCESS) {
+    logwarn("material: failed to get {} {} {} {}", key, type, idx, result);
+    return default_val;
+  }
+  return std::string(val.data);
+}
+enum PackedChannel : uint8_t {
+  kPackedOcclusion,
+  kPackedRoughness,
+  kPackedMetallic,
+  kPackedChannelNum,
+};
+struct Texture {
+  aiTextureType texture_type{static_cast<aiTextureType>(-1)};
+  std::string path;
+  std::array<std::string, kPackedChannelNum> packed_paths; // single channel maps packed to r,g,b by the converter, path is empty then
+};
+struct Sampler {
+  static const uint32_t kMapModeNum = 3;
+  aiTextureMapMode mapmode[kMapModeNum];
+  uint32_t mag_filter;
+  uint32_t min_filter;
+};
+auto IsValidMapMode(const aiTextureMapMode mapmode) {
+  switch (mapmode) {
+    case aiTextureMapMode_Wrap:
+      return true;
+    case aiTextureMapMode_Clamp:
+      return true;
+    case aiTextureMapMode_Decal:
+      return true;
+    case aiTextureMapMode_Mirror:
+      return true;
+  }
+  return false;
+}
+// lists are looked up by key for scenes with thousands of materials and textures
+struct TextureList {
+  std::vector<Texture> textures;
+  std::unordered_map<std::string, uint32_t> index_map;
+};
+struct SamplerList {
+  std::vector<Sampler> samplers;
+  std::unordered_map<std::string, uint32_t> index_map;
+};
+auto GetTextureKey(const Texture& texture) {
+  auto key = fmt::format("{}\n{}", static_cast<int32_t>(texture.texture_type), texture.path);
+  for (const auto& path : texture.packed_paths) {
+    key += '\n';
+    key += path;
+  }
+  return key;
+}
+auto GetSamplerKey(const aiTextureMapMode mapmode[3], const uint32_t mag_filter, const uint32_t min_filter) {
+  // invalid map modes are identical to each other
+  uint32_t key[Sampler::kMapModeNum + 2]{};
+  for (uint32_t i = 0; i < Sampler::kMapModeNum; i++) {
+    key[i] = IsValidMapMode(mapmode[i]) ? static_cast<uint32_t>(mapmode[i]) : ~0U;
+  }
+  key[Sampler::kMapModeNum] = mag_filter;
+  key[Sampler::kMapModeNum + 1] = min_filter;
+  return std::string(reinterpret_cast<const char*>(key), sizeof(key));
+}
+auto CreateTexture(const aiTextureType texture_type, const char* const path) {
+  return Texture{
+    .texture_type = texture_type,
+    .path = path,
+    .packed_paths = {},
+  };
+}
+constexpr auto CreateSampler(const aiTextureMapMode mapmode[3], const uint32_t mag_filter, const uint32_t min_filter) {
+  return Sampler{
+    .mapmode = {mapmode[0], mapmode[1], mapmode[2]},
+    .mag_filter = mag_filter,
+    .min_filter = min_filter,
+  };
+}
+auto FindOrCreateTexture(Texture&& texture, TextureList* texture_list) {
+  const auto [it, inserted] = texture_list->index_map.try_emplace(GetTextureKey(texture), GetUint32(texture_list->textures.size()));
+  if (inserted) {
+    texture_list->textures.push_back(std::move(texture));
+  }
+  return it->second;
+}
+auto FindOrCreateTexture(const aiTextureType texture_type, const char* const path, TextureList* textures) {
+  return FindOrCreateTexture(CreateTexture(texture_type, path), textures);
+}
+auto FindOrCreateSampler(const aiTextureMapMode mapmode[3], const uint32_t mag_filter, const uint32_t min_filter, SamplerList* sampler_list) {
+  const auto [it, inserted] = sampler_list->index_map.try_emplace(GetSamplerKey(mapmode, mag_filter, min_filter), GetUint32(sampler_list->samplers.size()));
+  if (inserted) {
+    sampler_list->samplers.push_back(CreateSampler(mapmode, mag_filter, min_filter));
+  }
+  return it->second;
+}
+const uint32_t SamplerFilter_UNSET = 0;
+const uint32_t SamplerMagFilter_Nearest = 9728;
+const uint32_t SamplerMagFilter_Linear = 9729;
+const uint32_t SamplerMinFilter_Nearest = 9728;
+const uint32_t SamplerMinFilter_Linear = 9729;
+const uint32_t SamplerMinFilter_Nearest_Mipmap_Nearest = 9984;
+const uint32_t SamplerMinFilter_Linear_Mipmap_Nearest = 9985;
+const uint32_t SamplerMinFilter_Nearest_Mipmap_Linear = 9986;
+const uint32_t SamplerMinFilter_Linear_Mipmap_Linear = 9987;
+auto CreateDefaultMaterial(const aiTextureType texture_type, TextureList* textures, SamplerList* samplers) {
+  nlohmann::json texture_json;
+  switch (texture_type) {
+    case aiTextureType_UNKNOWN: // occulusion-metallic-roughness
+      texture_json["texture"] = FindOrCreateTexture(aiTextureType_UNKNOWN, "yellow", textures);
+      break;
+    case aiTextureType_BASE_COLOR:
+      texture_json["texture"] = FindOrCreateTexture(aiTextureType_BASE_COLOR, "white", textures);
+      break;
+    case aiTextureType_NORMALS:
+      texture_json["texture"] = FindOrCreateTexture(aiTextureType_NORMALS, "normal", textures);
+      break;
+    case aiTextureType_EMISSIVE:
+      texture_json["texture"] = FindOrCreateTexture(aiTextureType_EMISSIVE, "black", textures);
+      break;
+  }
+  const aiTextureMapMode mapmode[] = {aiTextureMapMode_Wrap, aiTextureMapMode_Wrap, static_cast<aiTextureMapMode>(-1)};
+  texture_json["sampler"] = FindOrCreateSampler(mapmode, SamplerMagFilter_Linear, SamplerMinFilter_Linear_Mipmap_Linear, samplers);
+  return texture_json;
+}
+struct TextureSlot {
+  aiString path;
+  aiTextureMapMode mapmode[3];
+  uint32_t mag_filter{SamplerMagFilter_Linear};
+  uint32_t min_filter{SamplerMinFilter_Linear_Mipmap_Linear};
+};
+auto GetTextureSlot(const aiMaterial& material, const aiTextureType texture_type, TextureSlot* texture_slot) {
+  if (material.GetTextureCount(texture_type) == 0) {
+    return false;
+  }
+  if (material.GetTextureCount(texture_type) > 1) {
+    logwarn("multiple texture not implemented {}", texture_type);
+    return false;
+  }
+  aiTextureMapping mapping;
+  unsigned int uvindex;
+  ai_real blend;
+  aiTextureOp op;
+  const uint32_t slot = 0;
+  if (const auto result = material.GetTexture(texture_type, slot, &texture_slot->path, &mapping, &uvindex, &blend, &op, texture_slot->mapmode); result != AI_SUCCESS) {
+    return false;
+  }
+  if (mapping != aiTextureMapping::aiTextureMapping_UV) {
+    logerror("only uv mapping is supported {}", mapping);
+    return false;
+  }
+  if (uvindex != 0) {
+    logerror("only uv 0 supported so far. {}", uvindex);
+    return false;
+  }
+  aiUVTransform transform{};
+  if (const auto result = material.Get(AI_MATKEY_UVTRANSFORM(texture_type, slot), transform); result == AI_SUCCESS) {
+    // not needed so far.
+  }
+  material.Get(AI_MATKEY_GLTF_MAPPINGFILTER_MAG(texture_type, slot), texture_slot->mag_filter);
+  material.Get(AI_MATKEY_GLTF_MAPPINGFILTER_MIN(texture_type, slot), texture_slot->min_filter);
+  return true;
+}
+// source_type is looked up in material and stored as texture_type, e.g. diffuse maps of fbx as base color
+auto GetTexture(const aiMaterial& material, const aiTextureType texture_type, const aiTextureType source_type, TextureList* textures, SamplerList* samplers) {
+  TextureSlot texture_slot;
+  if (!GetTextureSlot(material, source_type, &texture_slot)) {
+    return CreateDefaultMaterial(texture_type, textures, samplers);
+  }
+  nlohmann::json texture_json;
+  texture_json["texture"] = FindOrCreateTexture(texture_type, texture_slot.path.C_Str(), textures);
+  texture_json["sampler"] = FindOrCreateSampler(texture_slot.mapmode, texture_slot.mag_filter, texture_slot.min_filter, samplers);
+  return texture_json;
+}
+auto GetTexture(const aiMaterial& material, const aiTextureType texture_type, TextureList* textures, SamplerList* samplers) {
+  return GetTexture(material, texture_type, texture_type, textures, samplers);
+}
+auto GetFirstTextureType(const aiMaterial& material, const std::initializer_list<aiTextureType> candidates) {
+  for (const auto texture_type : candidates) {
+    if (material.GetTextureCount(texture_type) > 0) { return texture_type; }
+  }
+  return *candidates.begin();
+}
+// separate occlusion, roughness and metallic maps of non-gltf materials are packed to a single texture in the gltf layout
+auto GetPackedOcclusionRoughnessMetallicTexture(const aiMaterial& material, TextureList* textures, SamplerList* samplers) {
+  const aiTextureType source_types[kPackedChannelNum] = {
+    GetFirstTextureType(material, {aiTextureType_AMBIENT_OCCLUSION, aiTextureType_LIGHTMAP}),
+    aiTextureType_DIFFUSE_ROUGHNESS,
+    aiTextureType_METALNESS,
+  };
+  Texture texture{.texture_type = aiTextureType_UNKNOWN, .path = {}, .packed_paths = {}};
+  std::optional<TextureSlot> sampler_slot;
+  for (uint32_t i = 0; i < kPackedChannelNum; i++) {
+    TextureSlot texture_slot;
+    if (!GetTextureSlot(material, source_types[i], &texture_slot)) { continue; }
+    texture.packed_paths[i] = texture_slot.path.C_Str();
+    if (!sampler_slot) {
+      sampler_slot = texture_slot;
+    }
+  }
+  if (!sampler_slot) {
+    return CreateDefaultMaterial(aiTextureType_UNKNOWN, textures, samplers);
+  }
+  nlohmann::json texture_json;
+  texture_json["texture"] = FindOrCreateTexture(std::move(texture), textures);
+  texture_json["sampler"] = FindOrCreateSampler(sampler_slot->mapmode, sampler_slot->mag_filter, sampler_slot->min_filter, samplers);
+  return texture_json;
+}
+std::string GetMapMode(const aiTextureMapMode mapmode) {
+  switch (mapmode) {
+    case aiTextureMapMode_Wrap:
+      return "wrap";
+    case aiTextureMapMode_Clamp:
+      return "clamp";
+    case aiTextureMapMode_Decal:
+      logwarn("aiTextureMapMode_Decal not implemented");
+      return "wrap";
+    case aiTextureMapMode_Mirror:
+      return "mirror";
+  }
+  return std::string();
+}
+std::string GetMagFilter(const uint32_t mag_filter) {
+  switch (mag_filter) {
+    case SamplerFilter_UNSET:
+      return "linear";
+    case SamplerMagFilter_Nearest:
+      return "point";
+    case SamplerMagFilter_Linear:
+      return "linear";
+  }
+  logerror("invalid value for mag filter {}", mag_filter);
+  return "linear";
+}
+std::string GetMinFilter(const uint32_t min_filter) {
+  switch (min_filter) {
+    case SamplerFilter_UNSET:
+      return "linear";
+    case SamplerMinFilter_Nearest:
+      return "point";
+    case SamplerMinFilter_Linear:
+      return "linear";
+    case SamplerMinFilter_Nearest_Mipmap_Nearest:
+      return "point";
+    case SamplerMinFilter_Linear_Mipmap_Nearest:
+      return "linear";
+    case SamplerMinFilter_Nearest_Mipmap_Linear:
+      return "point";
+    case SamplerMinFilter_Linear_Mipmap_Linear:
+      return "linear";
+  }
+  logerror("invalid value for min filter {}", min_filter);
+  return "linear";
+}
+std::string GetMipFilter(const uint32_t min_filter) {
+  switch (min_filter) {
+    case SamplerFilter_UNSET:
+      return "linear";
+    case SamplerMinFilter_Nearest:
+      return "linear";
+    case SamplerMinFilter_Linear:
+      return "linear";
+    case SamplerMinFilter_Nearest_Mipmap_Nearest:
+      return "point";
+    case SamplerMinFilter_Linear_Mipmap_Nearest:
+      return "point";
+    case SamplerMinFilter_Nearest_Mipmap_Linear:
+      return "linear";
+    case SamplerMinFilter_Linear_Mipmap_Linear:
+      return "linear";
+  }
+  logerror("invalid value for mip filter {}", min_filter);
+  return "linear";
+}
+auto IsPackedTexture(const Texture& texture) {
+  return std::any_of(texture.packed_paths.begin(), texture.packed_paths.end(), [](const std::string& path) { return !path.empty(); });
+}
+auto GetPackedTexturePath(const Texture& texture, std::unordered_set<std::string>* packed_texture_paths) {
+  // named after the first source map, written to the output directory
+  const auto& source_path = *std::find_if(texture.packed_paths.begin(), texture.packed_paths.end(), [](const std::string& path) { return !path.empty(); });
+  const auto stem = source_path.starts_with('*') ? fmt::format("embedded{}", source_path.substr(1)) : std::filesystem::path(source_path).stem().string();
+  auto path = fmt::format("textures/{}_orm.png", stem);
+  for (uint32_t i = 1; packed_texture_paths->contains(path); i++) {
+    path = fmt::format("textures/{}_orm_{}.png", stem, i);
+  }
+  packed_texture_paths->insert(path);
+  return path;
+}
+auto CreateTextureJson(const std::vector<Texture>& textures) {
+  auto json = nlohmann::json::array();
+  std::unordered_set<std::string> packed_texture_paths;
+  for (const auto& t : textures) {
+    nlohmann::json j;
+    switch (t.texture_type) {
+      case aiTextureType_UNKNOWN: // occulusion-metallic-roughness
+        j["type"] = "occulusion-metallic-roughness";
+        break;
+      case aiTextureType_BASE_COLOR:
+        j["type"] = "albedo";
+        break;
+      case aiTextureType_NORMALS:
+        j["type"] = "normal";
+        break;
+      case aiTextureType_EMISSIVE:
+        j["type"] = "emissive";
+        break;
+    }
+    if (IsPackedTexture(t)) {
+      j["path"] = GetPackedTexturePath(t, &packed_texture_paths);
+      const char* const channel_names[kPackedChannelNum] = {"occlusion", "roughness", "metallic"};
+      for (uint32_t i = 0; i < kPackedChannelNum; i++) {
+        if (t.packed_paths[i].empty()) { continue; }
+        j["sources"][channel_names[i]] = t.packed_paths[i];
+      }
+    } else {
+      j["path"] = t.path;
+    }
+    json.emplace_back(std::move(j));
+  }
+  return json;
+}
+auto CreateSamplerJson(const std::vector<Sampler>& samplers) {
+  auto json = nlohmann::json::array();
+  for (const auto& s : samplers) {
+    auto mapmode = nlohmann::json::array();
+    for (uint32_t i = 0; i < Sampler::kMapModeNum; i++) {
+      if (!IsValidMapMode(s.mapmode[i])) { continue; }
+      mapmode.emplace_back(GetMapMode(s.mapmode[i]));
+    }
+    nlohmann::json j;
+    j["mapmode"] = std::move(mapmode);
+    j["mag_filter"] = GetMagFilter(s.mag_filter);
+    j["min_filter"] = GetMinFilter(s.min_filter);
+    j["mip_filter"] = GetMipFilter(s.min_filter);
+    json.emplace_back(std::move(j));
+  }
+  return json;
+}
+struct MaterialData {
+  bool valid{false};
+  nlohmann::json json;
+  TextureList textures; // indices in json refer to these until merged
+  SamplerList samplers;
+};
+auto CreateMaterialData(const aiMaterial& material, const bool is_gltf) {
+  MaterialData material_data;
+  auto& material_json = material_data.json;
+  auto textures = &material_data.textures;
+  auto samplers = &material_data.samplers;
+  // other formats rarely store pbr shading mode, their pbr maps are used when present
+  if (is_gltf) {
+    if (const auto shading_mode = GetShadingMode(material); shading_mode != aiShadingMode_PBR_BRDF) {
+      logwarn("only pbr/brdf is loaded so far. {}", shading_mode);
+      return material_data;
+    }
+  }
+  // assimp/code/AssetLib/glTF2/glTF2Asset.h Material
+  // assimp/code/AssetLib/glTF2/glTF2Importer.cpp ImportMaterial
+  {
+    const auto source_type = is_gltf ? aiTextureType_BASE_COLOR : GetFirstTextureType(material, {aiTextureType_BASE_COLOR, aiTextureType_DIFFUSE});
+    material_json["albedo"]["texture"] = GetTexture(material, aiTextureType_BASE_COLOR, source_type, textures, samplers);
+    aiColor4D base_color;
+    const auto has_base_color = material.Get(AI_MATKEY_BASE_COLOR, base_color) == AI_SUCCESS;
+    material_json["albedo"]["factor"]  = (is_gltf || has_base_color) ? GetMaterialVal(material, AI_MATKEY_BASE_COLOR, {1.0f, 1.0f, 1.0f, 1.0f}) : GetMaterialVal(material, AI_MATKEY_COLOR_DIFFUSE, {1.0f, 1.0f, 1.0f, 1.0f});
+  }
+  // https://github.com/sbtron/glTF/blob/30de0b365d1566b1bbd8b9c140f9e995d3203226/specification/2.0/README.md#pbrmetallicroughnessmetallicroughnesstexture
+  {
+    auto& metallic_roughness_occlusion = material_json["metallic_roughness_occlusion"];
+    metallic_roughness_occlusion["texture"] = is_gltf
+        ? GetTexture(material, aiTextureType_UNKNOWN /*=AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE*/, textures, samplers)
+        : GetPackedOcclusionRoughnessMetallicTexture(material, textures, samplers);
+    metallic_roughness_occlusion["metallic_factor"] = GetMaterialVal(material, AI_MATKEY_METALLIC_FACTOR, 1.0f);
+    metallic_roughness_occlusion["roughness_factor"] = GetMaterialVal(material, AI_MATKEY_ROUGHNESS_FACTOR, 1.0f);
+    metallic_roughness_occlusion["occlusion_strength"] = GetMaterialVal(material, AI_MATKEY_GLTF_TEXTURE_STRENGTH(aiTextureType_LIGHTMAP, 0), 1.0f);
+  }
+  {
+    material_json["normal"]["texture"] = GetTexture(material, aiTextureType_NORMALS, textures, samplers);
+    material_json["normal"]["scale"]   = GetMaterialVal(material, AI_MATKEY_GLTF_TEXTURE_SCALE(aiTextureType_NORMALS, 0), 1.0f);
+  }
+  {
+    const auto source_type = is_gltf ? aiTextureType_EMISSIVE : GetFirstTextureType(material, {aiTextureType_EMISSIVE, aiTextureType_EMISSION_COLOR});
+    material_json["emissive"]["texture"] = GetTexture(material, aiTextureType_EMISSIVE, source_type, textures, samplers);
+    material_json["emissive"]["factor"]  = GetMaterialVal(material, AI_MATKEY_COLOR_EMISSIVE, {1.0f, 1.0f, 1.0f, 1.0f});
+  }
+  material_json["double_sided"] = GetMaterialVal(material, AI_MATKEY_TWOSIDED, false);
+  material_json["alpha_mode"] = GetMaterialStrVal(material, AI_MATKEY_GLTF_ALPHAMODE, "OPAQUE");
+  material_json["alpha_cutoff"] = GetMaterialVal(material, AI_MATKEY_GLTF_ALPHACUTOFF, 0.2f);
+  material_data.valid = true;
+  return material_data;
+}
+void MergeMaterialTextures(const MaterialData& material_data, nlohmann::json* material_json, TextureList* textures, SamplerList* samplers) {
+  // local lists are in first use order, merging them in material order gives the same indices as serial extraction
+  std::vector<uint32_t> texture_remap;
+  for (const auto& texture : material_data.textures.textures) {
+    texture_remap.push_back(FindOrCreateTexture(Texture{texture}, textures));
+  }
+  std::vector<uint32_t> sampler_remap;
+  for (const auto& sampler : material_data.samplers.samplers) {
+    sampler_remap.push_back(FindOrCreateSampler(sampler.mapmode, sampler.mag_filter, sampler.min_filter, samplers));
+  }
+  for (auto& [key, value] : material_json->items()) {
+    if (!value.is_object() || !value.contains("texture")) { continue; }
+    auto& texture_json = value["texture"];
+    texture_json["texture"] = texture_remap[texture_json["texture"].get<uint32_t>()];
+    texture_json["sampler"] = sampler_remap[texture_json["sampler"].get<uint32_t>()];
+  }
+}
+// materials with identical contents are merged, material_index_remap maps aiScene material indices to the output list (kInvalidIndex for materials not loaded)
+auto CreateJsonMaterialList(const uint32_t thread_num, const uint32_t material_num, const aiMaterial * const * const materials, const bool is_gltf, std::vector<uint32_t>* material_index_remap) {
+  std::vector<MaterialData> material_data_list(material_num);
+  ParallelFor(thread_num, material_num, [&](const uint32_t i) {
+    material_data_list[i] = CreateMaterialData(*(materials[i]), is_gltf);
+  });
+  auto json = nlohmann::json::array();
+  TextureList textures;
+  SamplerList samplers;
+  std::unordered_map<std::string, uint32_t> material_index_map;
+  material_index_remap->assign(material_num, kInvalidIndex);
+  for (uint32_t i = 0; i < material_num; i++) {
+    auto& material_data = material_data_list[i];
+    if (!material_data.valid) { continue; }
+    auto material_json = std::move(material_data.json);
+    MergeMaterialTextures(material_data, &material_json, &textures, &samplers);
+    // texture and sampler indices are global after merging, so the dump identifies the material contents
+    const auto [it, inserted] = material_index_map.try_emplace(material_json.dump(), GetUint32(json.size()));
+    (*material_index_remap)[i] = it->second;
+    if (inserted) {
+      json.emplace_back(std::move(material_json));
+    }
+  }
+  nlohmann::json ret;
+  ret["materials"] = std::move(json);
+  ret["textures"] = CreateTextureJson(textures.textures);
+  ret["samplers"] = CreateSamplerJson(samplers.samplers);
+  return ret;
+}
+void AssignMaterialIndices(const uint32_t mesh_num, const aiMesh* const * meshes, const std::vector<uint32_t>& material_index_remap, std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set) {
+  for (uint32_t i = 0; i < mesh_num; i++) {
+    const auto material_index = meshes[i]->mMaterialIndex;
+    (*per_draw_call_model_index_set)[i].material_index = material_index < material_index_remap.size() ? material_index_remap[material_index] : kInvalidIndex;
+  }
+}
+struct PostProcessStep {
+  uint32_t flag;
+  const char* name;
+};
+// in the order assimp applies them (see PostStepRegistry.cpp), so that applying them one by one gives the same scene
+constexpr PostProcessStep kPostProcessStepList[] = {
+  {aiProcess_ValidateDataStructure, "ValidateDataStructure"},
+  {aiProcess_MakeLeftHanded, "MakeLeftHanded"},
+  {aiProcess_FlipWindingOrder, "FlipWindingOrder"},
+  {aiProcess_RemoveRedundantMaterials, "RemoveRedundantMaterials"},
+  {aiProcess_FindInstances, "FindInstances"},
+  {aiProcess_GenUVCoords, "GenUVCoords"},
+  {aiProcess_TransformUVCoords, "TransformUVCoords"},
+  {aiProcess_Triangulate, "Triangulate"},
+  {aiProcess_FindDegenerates, "FindDegenerates"}, // after Triangulate to remove the degenerate triangles it generates
+  {aiProcess_SortByPType, "SortByPType"},
+  {aiProcess_FindInvalidData, "FindInvalidData"},
+  {aiProcess_OptimizeMeshes, "OptimizeMeshes"},
+  {aiProcess_FixInfacingNormals, "FixInfacingNormals"},
+  {aiProcess_GenSmoothNormals, "GenSmoothNormals"},
+  {aiProcess_CalcTangentSpace, "CalcTangentSpace"},
+  {aiProcess_JoinIdenticalVertices, "JoinIdenticalVertices"},
+  {aiProcess_Debone, "Debone"},
+};
+// triangles with normals and tangents are required by FillMeshData, coordinates are converted to left handed
+const uint32_t kFastPostProcessSteps = aiProcess_MakeLeftHanded
+                                       | aiProcess_FlipWindingOrder
+                                       | aiProcess_Triangulate
+                                       | aiProcess_SortByPType
+                                       | aiProcess_GenSmoothNormals
+                                       | aiProcess_CalcTangentSpace
+                                       | aiProcess_TransformUVCoords;
+const uint32_t kDefaultPostProcessSteps = kFastPostProcessSteps
+                                          | aiProcess_JoinIdenticalVertices
+                                          | aiProcess_ValidateDataStructure
+                                          | aiProcess_FixInfacingNormals
+                                          | aiProcess_FindInvalidData
+                                          | aiProcess_GenUVCoords
+                                          | aiProcess_FindInstances
+                                          | aiProcess_Debone
+                                          | aiProcess_RemoveRedundantMaterials;
+const uint32_t kThoroughPostProcessSteps = kDefaultPostProcessSteps
+                                           | aiProcess_FindDegenerates
+                                           | aiProcess_OptimizeMeshes;
+auto GetPresetPostProcessSteps(const PostProcessPreset preset) {
+  switch (preset) {
+    case PostProcessPreset::kFast: return kFastPostProcessSteps;
+    case PostProcessPreset::kDefault: return kDefaultPostProcessSteps;
+    case PostProcessPreset::kThorough: return kThoroughPostProcessSteps;
+  }
+  return kDefaultPostProcessSteps;
+}
+auto FindPostProcessStep(const std::string& name) -> const PostProcessStep* {
+  for (const auto& step : kPostProcessStepList) {
+    if (name == step.name) { return &step; }
+  }
+  return nullptr;
+}
+auto GetPostProcessSteps(const Options& options, uint32_t* post_process_steps) {
+  *post_process_steps = GetPresetPostProcessSteps(options.post_process_preset);
+  for (const auto* list : {&options.enabled_post_process_steps, &options.disabled_post_process_steps}) {
+    for (const auto& name : *list) {
+      const auto step = FindPostProcessStep(name);
+      if (step == nullptr) {
+        logerror("unknown post process step {}", name);
+        return false;
+      }
+      if (list == &options.enabled_post_process_steps) {
+        *post_process_steps |= step->flag;
+      } else {
+        *post_process_steps &= ~step->flag;
+      }
+    }
+  }
+  return true;
+}
+// bump when output for the same input and options changes
+const uint32_t kConverterVersion = 5;
+// texture codec sources are fetched by commit, their output may change without kConverterVersion
+#ifndef MODELCONV_TEXTURE_CODEC_REVISION
+#define MODELCONV_TEXTURE_CODEC_REVISION "unknown"
+#endif
+const std::string_view kTextureCodecRevision = MODELCONV_TEXTURE_CODEC_REVISION;
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+auto HashBytes(const void* data, const std::size_t size_in_bytes, uint64_t hash) {
+  const auto bytes = static_cast<const uint8_t*>(data);
+  for (std::size_t i = 0; i < size_in_bytes; i++) {
+    hash ^= bytes[i];
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+auto HashFile(const std::filesystem::path& filepath, uint64_t* hash) {
+  std::ifstream file(filepath, std::ios::in | std::ios::binary);
+  if (!file) { return false; }
+  const uint32_t kChunkSize = 1 << 20;
+  std::vector<char> chunk(kChunkSize);
+  while (file) {
+    file.read(chunk.data(), kChunkSize);
+    *hash = HashBytes(chunk.data(), static_cast<std::size_t>(file.gcount()), *hash);
+  }
+  return true;
+}
+auto CreateOptionsJson(const Options& options) {
+  // every option affecting output must be listed here to invalidate cache entries
+  nlohmann::json json;
+  json["optimize_mesh"] = options.optimize_mesh;
+  json["build_meshlets"] = options.build_meshlets;
+  json["meshlet_max_vertices"] = options.meshlet_max_vertices;
+  json["meshlet_max_triangles"] = options.meshlet_max_triangles;
+  json["lod_target_ratios"] = options.lod_target_ratios;
+  json["lod_target_error"] = options.lod_target_error;
+  json["quantize_vertex"] = options.quantize_vertex;
+  json["quantize_position"] = options.quantize_position;
+  json["texcoord_unorm16"] = options.texcoord_unorm16;
+  json["vertex_layout"] = GetVertexLayoutName(options.vertex_layout);
+  json["narrow_index_buffer"] = options.narrow_index_buffer;
+  json["output_json"] = options.output_json;
+  json["section_alignment"] = options.section_alignment;
+  json["group_streams_per_mesh"] = options.group_streams_per_mesh;
+  json["chunk_size_in_bytes"] = options.chunk_size_in_bytes;
+  json["spatial_cell_size"] = options.spatial_cell_size;
+  json["streaming_write"] = options.streaming_write;
+  json["merge_static_meshes"] = options.merge_static_meshes;
+  json["build_bvh"] = options.build_bvh;
+  json["static_batch_max_vertices"] = options.static_batch_max_vertices;
+  json["compress_textures"] = options.compress_textures;
+  json["texture_orm_bc1"] = options.texture_orm_bc1;
+  json["direct_gltf_import"] = options.direct_gltf_import;
+  return json;
+}
+auto ComputeCacheKey(const char* const input_filepath, const uint32_t post_process_steps, const Options& options, uint64_t* cache_key) {
+  auto hash = kFnvOffsetBasis;
+  if (!HashFile(input_filepath, &hash)) { return false; }
+  hash = HashBytes(&post_process_steps, sizeof(post_process_steps), hash);
+  hash = HashBytes(&kConverterVersion, sizeof(kConverterVersion), hash);
+  hash = HashBytes(kTextureCodecRevision.data(), kTextureCodecRevision.size(), hash);
+  const auto options_str = CreateOptionsJson(options).dump();
+  *cache_key = HashBytes(options_str.data(), options_str.size(), hash);
+  return true;
+}
+auto DecodeUri(const std::string& uri) {
+  std::string decoded;
+  decoded.reserve(uri.size());
+  for (std::size_t i = 0; i < uri.size(); i++) {
+    if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(uri[i + 1]) && isxdigit(uri[i + 2])) {
+      decoded.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+      i += 2;
+      continue;
+    }
+    decoded.push_back(uri[i]);
+  }
+  return decoded;
+}
+auto CollectCacheDependencies(const char* const input_filepath, const nlohmann::json& texture_list_json) {
+  // files read during conversion besides input_filepath itself
+  namespace fs = std::filesystem;
+  const auto input_directory = fs::path(input_filepath).parent_path();
+  std::vector<std::string> uris;
+  if (fs::path(input_filepath).extension() == ".gltf") {
+    std::ifstream gltf_file(input_filepath);
+    const auto gltf = nlohmann::json::parse(gltf_file, nullptr, false);
+    for (const auto* const key : {"buffers", "images"}) {
+      if (!gltf.is_object() || !gltf.contains(key)) { continue; }
+      for (const auto& entity : gltf[key]) {
+        if (!entity.contains("uri")) { continue; }
+        const auto uri = entity["uri"].get<std::string>();
+        if (uri.starts_with("data:")) { continue; }
+        uris.push_back(DecodeUri(uri));
+      }
+    }
+  }
+  for (const auto& texture : texture_list_json) {
+    if (texture.contains("sources")) {
+      for (const auto& source : texture["sources"]) {
+        uris.push_back(source.get<std::string>());
+      }
+      continue;
+    }
+    // path is replaced by the output dds file when textures are compressed
+    uris.push_back(texture[texture.contains("source_path") ? "source_path" : "path"].get<std::string>());
+  }
+  std::vector<std::string> dependencies;
+  for (const auto& uri : uris) {
+    // embedded textures ("*0") and default textures do not exist as files
+    const auto path = (input_directory / uri).lexically_normal();
+    if (!fs::is_regular_file(path)) { continue; }
+    dependencies.push_back(path.generic_string());
+  }
+  std::sort(dependencies.begin(), dependencies.end());
+  dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+  return dependencies;
+}
+auto GetCacheEntryPath(const char* const cache_dir, const uint64_t cache_key) {
+  const auto key_str = fmt::format("{:016x}", cache_key);
+  return std::filesystem::path(cache_dir) / key_str;
+}
+const char* const kCacheManifestFilename = "manifest.json";
+auto RestoreFromCache(const char* const cache_dir, const uint64_t cache_key, const char* const output_directory) {
+  namespace fs = std::filesystem;
+  const auto entry_path = GetCacheEntryPath(cache_dir, cache_key);
+  std::ifstream manifest_file(entry_path / kCacheManifestFilename);
+  if (!manifest_file) {
+    logdebug("cache miss: no entry {}", entry_path.generic_string());
+    return false;
+  }
+  const auto manifest = nlohmann::json::parse(manifest_file, nullptr, false);
+  if (!manifest.is_object() || !manifest.contains("dependencies") || !manifest.contains("files")) {
+    logwarn("cache miss: broken manifest {}", entry_path.generic_string());
+    return false;
+  }
+  for (const auto& dependency : manifest["dependencies"]) {
+    const auto path = dependency["path"].get<std::string>();
+    auto hash = kFnvOffsetBasis;
+    if (!HashFile(path, &hash) || hash != dependency["hash"].get<uint64_t>()) {
+      logdebug("cache miss: dependency changed {}", path);
+      return false;
+    }
+  }
+  std::error_code error_code;
+  fs::create_directories(output_directory, error_code);
+  for (const auto& file : manifest["files"]) {
+    const auto filename = file.get<std::string>();
+    fs::create_directories((fs::path(output_directory) / filename).parent_path(), error_code);
+    fs::copy_file(entry_path / filename, fs::path(output_directory) / filename, fs::copy_options::overwrite_existing, error_code);
+    if (error_code) {
+      logwarn("cache miss: failed to restore {} {}", filename, error_code.message());
+      return false;
+    }
+  }
+  return true;
+}
+void StoreToCache(const char* const cache_dir, const uint64_t cache_key, const std::vector<std::string>& dependencies, const char* const output_directory, const std::vector<std::string>& output_files) {
+  namespace fs = std::filesystem;
+  const auto entry_path = GetCacheEntryPath(cache_dir, cache_key);
+  // write to a temporary directory first so that concurrent conversions never see a partial entry
+  auto temp_path = entry_path;
+  temp_path += fmt::format(".tmp{}", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  std::error_code error_code;
+  fs::remove_all(temp_path, error_code);
+  fs::create_directories(temp_path, error_code);
+  nlohmann::json manifest;
+  manifest["dependencies"] = nlohmann::json::array();
+  for (const auto& dependency : dependencies) {
+    auto hash = kFnvOffsetBasis;
+    if (!HashFile(dependency, &hash)) { continue; }
+    manifest["dependencies"].push_back({{"path", dependency}, {"hash", hash}});
+  }
+  manifest["files"] = output_files;
+  for (const auto& filename : output_files) {
+    fs::create_directories((temp_path / filename).parent_path(), error_code);
+    fs::copy_file(fs::path(output_directory) / filename, temp_path / filename, fs::copy_options::overwrite_existing, error_code);
+    if (error_code) {
+      logwarn("failed to store {} to cache. {}", filename, error_code.message());
+      fs::remove_all(temp_path, error_code);
+      return;
+    }
+  }
+  WriteOutJson(manifest, (temp_path / kCacheManifestFilename).string().c_str());
+  fs::remove_all(entry_path, error_code);
+  fs::rename(temp_path, entry_path, error_code);
+  if (error_code) {
+    // another worker stored the same entry
+    fs::remove_all(temp_path, error_code);
+  }
+}
+enum class TextureCompression : uint8_t {
+  kBc7Srgb, // albedo, emissive
+  kBc7,     // occlusion-metallic-roughness
+  kBc1,     // occlusion-metallic-roughness with Options::texture_orm_bc1
+  kBc5,     // normal, x and y only
+};
+const uint32_t kBlockDim = 4;
+const uint32_t kRgbaComponentNum = 4;
+const uint32_t kBc1Level = 10; // rgbcx quality level, 0-18
+struct MipLevel {
+  uint32_t width{0};
+  uint32_t height{0};
+  std::vector<uint8_t> rgba;
+  std::vector<uint8_t> blocks;
+};
+struct TextureJob {
+  uint32_t texture_index{0}; // in material settings
+  std::string source_path;
+  std::string output_path; // relative to output directory
+  TextureCompression compression{TextureCompression::kBc7};
+  std::vector<MipLevel> mips;
+};
+auto GetTextureCompression(const std::string& type, const bool orm_bc1) {
+  if (type == "albedo" || type == "emissive") { return TextureCompression::kBc7Srgb; }
+  if (type == "normal") { return TextureCompression::kBc5; }
+  return orm_bc1 ? TextureCompression::kBc1 : TextureCompression::kBc7;
+}
+auto GetBlockSizeInBytes(const TextureCompression compression) -> uint32_t {
+  return compression == TextureCompression::kBc1 ? 8 : 16;
+}
+auto GetDxgiFormat(const TextureCompression compression) -> uint32_t {
+  switch (compression) {
+    case TextureCompression::kBc7Srgb: return 99; // DXGI_FORMAT_BC7_UNORM_SRGB
+    case TextureCompression::kBc7: return 98;     // DXGI_FORMAT_BC7_UNORM
+    case TextureCompression::kBc1: return 71;     // DXGI_FORMAT_BC1_UNORM
+    case TextureCompression::kBc5: return 83;     // DXGI_FORMAT_BC5_UNORM
+  }
+  return 0;
+}
+auto GetTextureCompressionName(const TextureCompression compression) {
+  switch (compression) {
+    case TextureCompression::kBc7Srgb: return "BC7_UNORM_SRGB";
+    case TextureCompression::kBc7: return "BC7_UNORM";
+    case TextureCompression::kBc1: return "BC1_UNORM";
+    case TextureCompression::kBc5: return "BC5_UNORM";
+  }
+  return "unknown";
+}
+auto DecodeImage(const aiScene& scene, const std::filesystem::path& input_directory, const std::string& path, MipLevel* image) {
+  int width = 0, height = 0, channel_num = 0;
+  stbi_uc* pixels = nullptr;
+  if (path.starts_with('*')) {
+    const auto texture = scene.GetEmbeddedTexture(path.c_str());
+    if (texture == nullptr) { return false; }
+    if (texture->mHeight != 0) {
+      // uncompressed embedded texture
+      image->width = texture->mWidth;
+      image->height = texture->mHeight;
+      image->rgba.resize(std::size_t{image->width} * image->height * kRgbaComponentNum);
+      for (std::size_t i = 0; i < std::size_t{image->width} * image->height; i++) {
+        const auto& texel = texture->pcData[i];
+        const uint8_t rgba[] = {texel.r, texel.g, texel.b, texel.a};
+        memcpy(&image->rgba[i * kRgbaComponentNum], rgba, kRgbaComponentNum);
+      }
+      return true;
+    }
+    pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(texture->pcData), static_cast<int>(texture->mWidth), &width, &height, &channel_num, kRgbaComponentNum);
+  } else {
+    pixels = stbi_load((input_directory / path).string().c_str(), &width, &height, &channel_num, kRgbaComponentNum);
+  }
+  if (pixels == nullptr) {
+    logwarn("failed to decode {} {}", path, stbi_failure_reason());
+    return false;
+  }
+  image->width = static_cast<uint32_t>(width);
+  image->height = static_cast<uint32_t>(height);
+  image->rgba.assign(pixels, pixels + std::size_t{image->width} * image->height * kRgbaComponentNum);
+  stbi_image_free(pixels);
+  return true;
+}
+// r,g,b of packed textures from "sources" of texture json, in the gltf occlusion-roughness-metallic layout
+auto PackTexture(const aiScene& scene, const std::filesystem::path& input_directory, const nlohmann::json& sources, const uint32_t thread_num, MipLevel* image) {
+  const char* const channel_names[kPackedChannelNum] = {"occlusion", "roughness", "metallic"};
+  const uint8_t default_values[kPackedChannelNum] = {255, 255, 0}; // same as the default "yellow" texture
+  MipLevel source_images[kPackedChannelNum];
+  image->width = 1;
+  image->height = 1;
+  for (uint32_t i = 0; i < kPackedChannelNum; i++) {
+    if (!sources.contains(channel_names[i])) { continue; }
+    // missing maps fall back to the default value so that other channels are still usable
+    if (!DecodeImage(scene, input_directory, sources[channel_names[i]].get<std::string>(), &source_images[i])) { continue; }
+    image->width = std::max(image->width, source_images[i].width);
+    image->height = std::max(image->height, source_images[i].height);
+  }
+  image->rgba.resize(std::size_t{image->width} * image->height * kRgbaComponentNum);
+  // tiles keep the rows of each source read by a thread close together
+  const uint32_t kTileDim = 64;
+  const auto tile_x_num = (image->width + kTileDim - 1) / kTileDim;
+  const auto tile_y_num = (image->height + kTileDim - 1) / kTileDim;
+  ParallelFor(thread_num, tile_x_num * tile_y_num, [&](const uint32_t tile_index) {
+    const auto x_begin = tile_index % tile_x_num * kTileDim;
+    const auto y_begin = tile_index / tile_x_num * kTileDim;
+    const auto x_end = std::min(x_begin + kTileDim, image->width);
+    const auto y_end = std::min(y_begin + kTileDim, image->height);
+    for (uint32_t y = y_begin; y < y_end; y++) {
+      for (uint32_t x = x_begin; x < x_end; x++) {
+        auto dst = &image->rgba[(std::size_t{y} * image->width + x) * kRgbaComponentNum];
+        for (uint32_t c = 0; c < kPackedChannelNum; c++) {
+          const auto& src = source_images[c];
+          if (src.rgba.empty()) {
+            dst[c] = default_values[c];
+            continue;
+          }
+          // nearest texel for sources smaller than the packed texture, red of grayscale maps
+          const auto src_x = static_cast<uint32_t>(uint64_t{x} * src.width / image->width);
+          const auto src_y = static_cast<uint32_t>(uint64_t{y} * src.height / image->height);
+          dst[c] = src.rgba[(std::size_t{src_y} * src.width + src_x) * kRgbaComponentNum];
+        }
+        dst[3] = 255;
+      }
+    }
+  });
+  return true;
+}
+auto DecodeTexture(const aiScene& scene, const std::filesystem::path& input_directory, const nlohmann::json& texture_json, const uint32_t thread_num, MipLevel* image) {
+  if (texture_json.contains("sources")) {
+    return PackTexture(scene, input_directory, texture_json["sources"], thread_num, image);
+  }
+  return DecodeImage(scene, input_directory, texture_json["path"].get<std::string>(), image);
+}
+// writes textures packed by the converter as png when textures are not compressed
+void WritePackedTextures(const aiScene& scene, const char* const input_directory, const char* const output_directory, const uint32_t thread_num, const nlohmann::json& texture_list_json, std::vector<std::string>* output_files) {
+  for (const auto& texture : texture_list_json) {
+    if (!texture.contains("sources")) { continue; }
+    MipLevel image;
+    DecodeTexture(scene, input_directory, texture, thread_num, &image);
+    const auto path = texture["path"].get<std::string>();
+    const auto filepath = std::filesystem::path(output_directory) / path;
+    std::filesystem::create_directories(filepath.parent_path());
+    if (stbi_write_png(filepath.string().c_str(), static_cast<int>(image.width), static_cast<int>(image.height), kRgbaComponentNum, image.rgba.data(), static_cast<int>(image.width * kRgbaComponentNum)) == 0) {
+      logwarn("failed to write {}", filepath.generic_string());
+      continue;
+    }
+    output_files->push_back(path);
+  }
+}
+auto CreateSrgbToLinearTable() {
+  std::array<float, 256> table{};
+  for (uint32_t i = 0; i < table.size(); i++) {
+    const auto c = static_cast<float>(i) / 255.0f;
+    table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+  }
+  return table;
+}
+auto LinearToSrgb(const float c) {
+  const auto srgb = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+  return static_cast<uint8_t>(std::clamp(srgb, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+auto UnormToByte(const float c) {
+  return static_cast<uint8_t>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+// 2x2 box filter, averaged in linear space for srgb and renormalized for normal maps
+auto DownsampleImage(const MipLevel& src, const TextureCompression compression) {
+  static const auto srgb_to_linear = CreateSrgbToLinearTable();
+  MipLevel dst;
+  dst.width = std::max(src.width / 2, 1U);
+  dst.height = std::max(src.height / 2, 1U);
+  dst.rgba.resize(std::size_t{dst.width} * dst.height * kRgbaComponentNum);
+  for (uint32_t y = 0; y < dst.height; y++) {
+    for (uint32_t x = 0; x < dst.width; x++) {
+      float sum[kRgbaComponentNum]{};
+      for (uint32_t i = 0; i < 4; i++) {
+        const auto src_x = std::min(x * 2 + i % 2, src.width - 1);
+        const auto src_y = std::min(y * 2 + i / 2, src.height - 1);
+        const auto texel = &src.rgba[(std::size_t{src_y} * src.width + src_x) * kRgbaComponentNum];
+        for (uint32_t c = 0; c < kRgbaComponentNum; c++) {
+          sum[c] += (compression == TextureCompression::kBc7Srgb && c < 3) ? srgb_to_linear[texel[c]] : static_cast<float>(texel[c]) / 255.0f;
+        }
+      }
+      auto dst_texel = &dst.rgba[(std::size_t{y} * dst.width + x) * kRgbaComponentNum];
+      if (compression == TextureCompression::kBc5) {
+        float normal[3];
+        for (uint32_t c = 0; c < 3; c++) {
+          normal[c] = sum[c] * 0.5f - 1.0f; // average of 4 mapped from [0,1] to [-1,1]
+        }
+        const auto len = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (uint32_t c = 0; c < 3; c++) {
+          dst_texel[c] = UnormToByte(len > 0.0f ? normal[c] / len * 0.5f + 0.5f : 0.5f);
+        }
+        dst_texel[3] = UnormToByte(sum[3] * 0.25f);
+        continue;
+      }
+      for (uint32_t c = 0; c < kRgbaComponentNum; c++) {
+        dst_texel[c] = (compression == TextureCompression::kBc7Srgb && c < 3) ? LinearToSrgb(sum[c] * 0.25f) : UnormToByte(sum[c] * 0.25f);
+      }
+    }
+  }
+  return dst;
+}
+auto CreateMipChain(MipLevel&& image, const TextureCompression compression) {
+  std::vector<MipLevel> mips;
+  mips.push_back(std::move(image));
+  while (mips.back().width > 1 || mips.back().height > 1) {
+    mips.push_back(DownsampleImage(mips.back(), compression));
+  }
+  return mips;
+}
+struct BlockEncoder {
+  bc7enc_compress_block_params bc7_linear;
+  bc7enc_compress_block_params bc7_perceptual;
+};
+auto GetBlockEncoder() -> const BlockEncoder& {
+  static const auto encoder = []() {
+    bc7enc_compress_block_init();
+    rgbcx::init();
+    BlockEncoder e{};
+    bc7enc_compress_block_params_init(&e.bc7_linear);
+    bc7enc_compress_block_params_init_linear_weights(&e.bc7_linear);
+    bc7enc_compress_block_params_init(&e.bc7_perceptual);
+    bc7enc_compress_block_params_init_perceptual_weights(&e.bc7_perceptual);
+    return e;
+  }();
+  return encoder;
+}
+void CompressBlockRow(const TextureCompression compression, const uint32_t block_y, MipLevel* mip) {
+  const auto& encoder = GetBlockEncoder();
+  const auto block_x_num = (mip->width + kBlockDim - 1) / kBlockDim;
+  const auto block_size_in_bytes = GetBlockSizeInBytes(compression);
+  uint8_t texels[kBlockDim * kBlockDim * kRgbaComponentNum];
+  for (uint32_t block_x = 0; block_x < block_x_num; block_x++) {
+    // edge texels are repeated for sizes not multiple of 4
+    for (uint32_t i = 0; i < kBlockDim * kBlockDim; i++) {
+      const auto x = std::min(block_x * kBlockDim + i % kBlockDim, mip->width - 1);
+      const auto y = std::min(block_y * kBlockDim + i / kBlockDim, mip->height - 1);
+      memcpy(&texels[i * kRgbaComponentNum], &mip->rgba[(std::size_t{y} * mip->width + x) * kRgbaComponentNum], kRgbaComponentNum);
+    }
+    auto dst = &mip->blocks[(std::size_t{block_y} * block_x_num + block_x) * block_size_in_bytes];
+    switch (compression) {
+      case TextureCompression::kBc7Srgb:
+        bc7enc_compress_block(dst, texels, &encoder.bc7_perceptual);
+        break;
+      case TextureCompression::kBc7:
+        bc7enc_compress_block(dst, texels, &encoder.bc7_linear);
+        break;
+      case TextureCompression::kBc1:
+        rgbcx::encode_bc1(kBc1Level, dst, texels, false, false);
+        break;
+      case TextureCompression::kBc5:
+        rgbcx::encode_bc5(dst, texels, 0, 1, kRgbaComponentNum);
+        break;
+    }
+  }
+}
+struct DdsPixelFormat {
+  uint32_t size;
+  uint32_t flags;
+  uint32_t four_cc;
+  uint32_t rgb_bit_count;
+  uint32_t bit_mask[4];
+};
+struct DdsHeader {
+  uint32_t magic;
+  uint32_t size;
+  uint32_t flags;
+  uint32_t height;
+  uint32_t width;
+  uint32_t pitch_or_linear_size;
+  uint32_t depth;
+  uint32_t mip_map_count;
+  uint32_t reserved1[11];
+  DdsPixelFormat pixel_format;
+  uint32_t caps[4];
+  uint32_t reserved2;
+  // DDS_HEADER_DXT10
+  uint32_t dxgi_format;
+  uint32_t resource_dimension;
+  uint32_t misc_flag;
+  uint32_t array_size;
+  uint32_t misc_flags2;
+};
+static_assert(sizeof(DdsHeader) == 4 + 124 + 20);
+auto CreateDdsHeader(const TextureJob& job) {
+  const uint32_t kDdsMagic = 0x20534444; // "DDS "
+  const uint32_t kDdsHeaderFlags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // caps, height, width, pixelformat, mipmapcount, linearsize
+  const uint32_t kDdsPixelFormatFourCc = 0x4;
+  const uint32_t kFourCcDx10 = 0x30315844; // "DX10"
+  const uint32_t kDdsCaps = 0x8 | 0x1000 | 0x400000; // complex, texture, mipmap
+  const uint32_t kResourceDimensionTexture2d = 3;
+  DdsHeader header{};
+  header.magic = kDdsMagic;
+  header.size = 124;
+  header.flags = kDdsHeaderFlags;
+  header.height = job.mips[0].height;
+  header.width = job.mips[0].width;
+  header.pitch_or_linear_size = GetUint32(job.mips[0].blocks.size());
+  header.depth = 1;
+  header.mip_map_count = GetUint32(job.mips.size());
+  header.pixel_format.size = sizeof(DdsPixelFormat);
+  header.pixel_format.flags = kDdsPixelFormatFourCc;
+  header.pixel_format.four_cc = kFourCcDx10;
+  header.caps[0] = kDdsCaps;
+  header.dxgi_format = GetDxgiFormat(job.compression);
+  header.resource_dimension = kResourceDimensionTexture2d;
+  header.array_size = 1;
+  return header;
+}
+void WriteDdsFile(const TextureJob& job, const std::filesystem::path& filepath) {
+  std::ofstream output_file(filepath, std::ios::out | std::ios::binary);
+  const auto header = CreateDdsHeader(job);
+  OutputBinaryToFile(sizeof(header), &header, &output_file);
+  for (const auto& mip : job.mips) {
+    OutputBinaryToFile(mip.blocks.size(), mip.blocks.data(), &output_file);
+  }
+}
+auto CreateTextureJobs(const nlohmann::json& texture_list_json, const bool orm_bc1) {
+  std::vector<TextureJob> jobs;
+  std::unordered_set<std::string> output_paths;
+  for (uint32_t i = 0; i < texture_list_json.size(); i++) {
+    const auto& texture = texture_list_json[i];
+    const auto path = texture["path"].get<std::string>();
+    const auto embedded = path.starts_with('*');
+    // default textures ("white", "normal", ...) are provided by the renderer
+    if (!embedded && std::filesystem::path(path).extension().empty()) { continue; }
+    TextureJob job;
+    job.texture_index = i;
+    job.source_path = path;
+    job.compression = GetTextureCompression(texture["type"].get<std::string>(), orm_bc1);
+    const auto stem = embedded ? fmt::format("embedded{}", path.substr(1)) : std::filesystem::path(path).stem().string();
+    job.output_path = fmt::format("textures/{}.dds", stem);
+    if (output_paths.contains(job.output_path)) {
+      job.output_path = fmt::format("textures/{}_{}.dds", stem, i);
+    }
+    output_paths.insert(job.output_path);
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+// decodes textures referenced by the material list, generates mips and bc compresses them to dds files in the output directory.
+// paths in texture_list_json are replaced by the dds paths, the originals are kept as source_path.
+void CompressTextures(const aiScene& scene, const char* const input_directory, const char* const output_directory, const Options& options, nlohmann::json* texture_list_json, std::vector<std::string>* output_files) {
+  auto jobs = CreateTextureJobs(*texture_list_json, options.texture_orm_bc1);
+  if (jobs.empty()) { return; }
+  std::filesystem::create_directories(std::filesystem::path(output_directory) / "textures");
+  // decoded images are kept for one texture per thread at a time to bound memory
+  const auto group_size = GetThreadNum(options.thread_num);
+  for (uint32_t group_start = 0; group_start < jobs.size(); group_start += group_size) {
+    const auto group_num = std::min(group_size, GetUint32(jobs.size()) - group_start);
+    ParallelFor(options.thread_num, group_num, [&](const uint32_t i) {
+      auto& job = jobs[group_start + i];
+      MipLevel image;
+      // packing runs single threaded here as textures are already decoded in parallel
+      if (!DecodeTexture(scene, input_directory, (*texture_list_json)[job.texture_index], 1, &image)) { return; }
+      job.mips = CreateMipChain(std::move(image), job.compression);
+    });
+    // block rows of all mips in the group are compressed together so that a few large textures still use all threads
+    struct BlockRow {
+      TextureJob* job;
+      MipLevel* mip;
+      uint32_t block_y;
+    };
+    std::vector<BlockRow> block_rows;
+    for (uint32_t i = 0; i < group_num; i++) {
+      auto& job = jobs[group_start + i];
+      for (auto& mip : job.mips) {
+        const auto block_x_num = (mip.width + kBlockDim - 1) / kBlockDim;
+        const auto block_y_num = (mip.height + kBlockDim - 1) / kBlockDim;
+        mip.blocks.resize(std::size_t{block_x_num} * block_y_num * GetBlockSizeInBytes(job.compression));
+        for (uint32_t y = 0; y < block_y_num; y++) {
+          block_rows.push_back(BlockRow{.job = &job, .mip = &mip, .block_y = y});
+        }
+      }
+    }
+    ParallelFor(options.thread_num, GetUint32(block_rows.size()), [&](const uint32_t i) {
+      CompressBlockRow(block_rows[i].job->compression, block_rows[i].block_y, block_rows[i].mip);
+    });
+    ParallelFor(options.thread_num, group_num, [&](const uint32_t i) {
+      auto& job = jobs[group_start + i];
+      if (job.mips.empty()) { return; }
+      WriteDdsFile(job, std::filesystem::path(output_directory) / job.output_path);
+    });
+    for (uint32_t i = 0; i < group_num; i++) {
+      auto& job = jobs[group_start + i];
+      if (job.mips.empty()) { continue; }
+      auto& texture = (*texture_list_json)[job.texture_index];
+      if (!texture.contains("sources")) {
+        texture["source_path"] = job.source_path;
+      }
+      texture["path"] = job.output_path;
+      texture["format"] = GetTextureCompressionName(job.compression);
+      output_files->push_back(job.output_path);
+      job.mips = {};
+    }
+  }
+}
+auto ApplyPostProcessSteps(const aiScene* scene, const uint32_t post_process_steps, Assimp::Importer* importer, ConversionMetrics* metrics) {
+  // steps are applied one by one to time each of them
+  for (const auto& step : kPostProcessStepList) {
+    if (scene == nullptr) { break; }
+    if ((post_process_steps & step.flag) == 0) { continue; }
+    scene = MeasureStage(step.name, metrics, [&]() { return importer->ApplyPostProcessing(step.flag); });
+  }
+  return scene;
+}
+auto ImportScene(const char* const input_filepath, const uint32_t post_process_steps, Assimp::Importer* importer, ConversionMetrics* metrics) {
+  const auto scene = MeasureStage("import", metrics, [&]() { return importer->ReadFile(input_filepath, 0); });
+  return ApplyPostProcessSteps(scene, post_process_steps, importer, metrics);
+}
+auto ImportSceneFromMemory(const void* const data, const std::size_t size_in_bytes, const char* const format_hint, const uint32_t post_process_steps, Assimp::Importer* importer, ConversionMetrics* metrics) {
+  const auto scene = MeasureStage("import", metrics, [&]() { return importer->ReadFileFromMemory(data, size_in_bytes, 0, format_hint); });
+  return ApplyPostProcessSteps(scene, post_process_steps, importer, metrics);
+}
+// whole file mapped read only, pages are loaded on access instead of copied to the heap up front
+class MappedFile {
+ public:
+  explicit MappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) { return; }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) { return; }
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr) { return; }
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ != nullptr) { size_ = static_cast<std::size_t>(size.QuadPart); }
+#else
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return; }
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+      const auto data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        data_ = static_cast<const uint8_t*>(data);
+        size_ = static_cast<std::size_t>(status.st_size);
+      }
+    }
+    close(fd);
+#endif
+  }
+  ~MappedFile() {
+#if defined(_WIN32)
+    if (data_ != nullptr) { UnmapViewOfFile(data_); }
+    if (mapping_ != nullptr) { CloseHandle(mapping_); }
+    if (file_ != INVALID_HANDLE_VALUE) { CloseHandle(file_); }
+#else
+    if (data_ != nullptr) { munmap(const_cast<uint8_t*>(data_), size_); }
+#endif
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  // empty if the file could not be mapped
+  auto GetData() const { return std::span<const uint8_t>(data_, size_); }
+ private:
+  const uint8_t* data_{nullptr};
+  std::size_t size_{0};
+#if defined(_WIN32)
+  HANDLE file_{INVALID_HANDLE_VALUE};
+  HANDLE mapping_{nullptr};
+#endif
+};
+// https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html
+const uint32_t kGlbMagic = 0x46546C67;         // "glTF"
+const uint32_t kGlbChunkTypeJson = 0x4E4F534A; // "JSON"
+const uint32_t kGlbChunkTypeBin = 0x004E4942;  // "BIN\0"
+const uint32_t kGltfComponentTypeUnsignedByte = 5121;
+const uint32_t kGltfComponentTypeUnsignedShort = 5123;
+const uint32_t kGltfComponentTypeUnsignedInt = 5125;
+const uint32_t kGltfComponentTypeFloat = 5126;
+const uint32_t kGltfModeTriangles = 4;
+const uint32_t kGltfWrapClampToEdge = 33071;
+const uint32_t kGltfWrapMirroredRepeat = 33648;
+// extensions not affecting anything the converter reads, files using others are left to assimp
+const char* const kGltfIgnorableExtensions[] = {"KHR_lights_punctual", "KHR_materials_ior", "KHR_materials_specular"};
+auto GetGltfElement(const nlohmann::json& gltf, const char* const key, const uint32_t index) -> const nlohmann::json* {
+  if (!gltf.contains(key) || !gltf[key].is_array() || index >= gltf[key].size()) { return nullptr; }
+  return &gltf[key][index];
+}
+auto GetGltfIndex(const nlohmann::json& json, const char* const key, uint32_t* index) {
+  if (!json.contains(key) || !json[key].is_number_unsigned()) { return false; }
+  *index = json[key].get<uint32_t>();
+  return true;
+}
+auto GetGltfUint(const nlohmann::json& json, const char* const key, const uint64_t default_val) {
+  if (!json.contains(key) || !json[key].is_number_unsigned()) { return default_val; }
+  return json[key].get<uint64_t>();
+}
+auto GetGltfString(const nlohmann::json& json, const char* const key) {
+  if (!json.contains(key) || !json[key].is_string()) { return std::string(); }
+  return json[key].get<std::string>();
+}
+auto GetGltfFloat(const nlohmann::json& json, const char* const key, const float default_val) {
+  if (!json.contains(key) || !json[key].is_number()) { return default_val; }
+  return json[key].get<float>();
+}
+template <std::size_t N>
+auto GetGltfFloats(const nlohmann::json& json, const char* const key, float (&dst)[N]) {
+  if (!json.contains(key) || !json[key].is_array() || json[key].size() != N) { return false; }
+  CopyFactor(json[key], dst);
+  return true;
+}
+auto HasOnlyIgnorableGltfExtensions(const nlohmann::json& gltf) {
+  if (!gltf.contains("extensionsUsed")) { return true; }
+  for (const auto& extension : gltf["extensionsUsed"]) {
+    const auto is_ignorable = std::any_of(std::begin(kGltfIgnorableExtensions), std::end(kGltfIgnorableExtensions), [&](const char* const name) { return extension == name; });
+    if (!is_ignorable) {
+      logdebug("direct gltf import: extension {}", extension.dump());
+      return false;
+    }
+  }
+  return true;
+}
+// .gltf json or .glb with a json chunk and an optional binary chunk
+auto ParseGltfFile(const std::span<const uint8_t> file, nlohmann::json* gltf, std::span<const uint8_t>* bin_chunk) {
+  const uint32_t kGlbHeaderSizeInBytes = 12;
+  uint32_t magic = 0;
+  if (file.size() >= sizeof(magic)) {
+    memcpy(&magic, file.data(), sizeof(magic));
+  }
+  if (magic != kGlbMagic) {
+    *gltf = nlohmann::json::parse(file.begin(), file.end(), nullptr, false);
+    return gltf->is_object();
+  }
+  std::size_t offset = kGlbHeaderSizeInBytes;
+  uint32_t chunk_header[2]{}; // length, type
+  while (offset + sizeof(chunk_header) <= file.size()) {
+    memcpy(chunk_header, file.data() + offset, sizeof(chunk_header));
+    offset += sizeof(chunk_header);
+    if (chunk_header[0] > file.size() - offset) { return false; }
+    const auto chunk = file.subspan(offset, chunk_header[0]);
+    if (chunk_header[1] == kGlbChunkTypeJson && gltf->is_null()) {
+      *gltf = nlohmann::json::parse(chunk.begin(), chunk.end(), nullptr, false);
+    }
+    if (chunk_header[1] == kGlbChunkTypeBin && bin_chunk->empty()) {
+      *bin_chunk = chunk;
+    }
+    offset += chunk_header[0];
+  }
+  return gltf->is_object();
+}
+// input_directory is nullptr for files in memory, external buffers cannot be resolved then
+auto MapGltfBuffers(const nlohmann::json& gltf, const std::span<const uint8_t> bin_chunk, const char* const input_directory, std::vector<std::unique_ptr<MappedFile>>* mapped_files, std::vector<std::span<const uint8_t>>* buffers) {
+  if (!gltf.contains("buffers")) { return true; }
+  for (const auto& buffer : gltf["buffers"]) {
+    const auto size_in_bytes = GetGltfUint(buffer, "byteLength", 0);
+    if (!buffer.contains("uri")) {
+      if (bin_chunk.size() < size_in_bytes) { return false; }
+      buffers->push_back(bin_chunk.first(size_in_bytes));
+      continue;
+    }
+    const auto uri = GetGltfString(buffer, "uri");
+    if (input_directory == nullptr || uri.empty() || uri.starts_with("data:")) {
+      logdebug("direct gltf import: buffer uri not mappable {}", uri.substr(0, 32));
+      return false;
+    }
+    auto mapped_file = std::make_unique<MappedFile>(std::filesystem::path(input_directory) / DecodeUri(uri));
+    const auto data = mapped_file->GetData();
+    if (data.size() < size_in_bytes) { return false; }
+    buffers->push_back(data.first(size_in_bytes));
+    mapped_files->push_back(std::move(mapped_file));
+  }
+  return true;
+}
+struct GltfAccessor {
+  const uint8_t* data{nullptr};
+  uint32_t count{0};
+  uint32_t stride_in_bytes{0};
+  uint32_t component_type{0};
+  uint32_t component_num{0};
+};
+auto GetGltfComponentSizeInBytes(const uint64_t component_type) -> uint32_t {
+  switch (component_type) {
+    case kGltfComponentTypeUnsignedByte: return 1;
+    case kGltfComponentTypeUnsignedShort: return 2;
+    case kGltfComponentTypeUnsignedInt: return 4;
+    case kGltfComponentTypeFloat: return 4;
+  }
+  return 0;
+}
+auto GetGltfComponentNum(const std::string& type) -> uint32_t {
+  if (type == "SCALAR") { return 1; }
+  if (type == "VEC2") { return 2; }
+  if (type == "VEC3") { return 3; }
+  if (type == "VEC4") { return 4; }
+  return 0;
+}
+// sparse accessors and accessors without buffer view are not supported
+auto GetGltfAccessor(const nlohmann::json& gltf, const std::vector<std::span<const uint8_t>>& buffers, const uint32_t accessor_index, GltfAccessor* accessor) {
+  const auto accessor_json = GetGltfElement(gltf, "accessors", accessor_index);
+  uint32_t buffer_view_index = 0;
+  if (accessor_json == nullptr || accessor_json->contains("sparse") || !GetGltfIndex(*accessor_json, "bufferView", &buffer_view_index)) { return false; }
+  const auto buffer_view = GetGltfElement(gltf, "bufferViews", buffer_view_index);
+  uint32_t buffer_index = 0;
+  if (buffer_view == nullptr || !GetGltfIndex(*buffer_view, "buffer", &buffer_index) || buffer_index >= buffers.size()) { return false; }
+  const auto component_type = GetGltfUint(*accessor_json, "componentType", 0);
+  const uint64_t element_size_in_bytes = GetGltfComponentSizeInBytes(component_type) * GetGltfComponentNum(GetGltfString(*accessor_json, "type"));
+  const auto count = GetGltfUint(*accessor_json, "count", 0);
+  const auto stride_in_bytes = GetGltfUint(*buffer_view, "byteStride", element_size_in_bytes);
+  if (element_size_in_bytes == 0 || count == 0 || count > std::numeric_limits<uint32_t>::max() || stride_in_bytes < element_size_in_bytes) { return false; }
+  const auto& buffer = buffers[buffer_index];
+  const auto view_offset = GetGltfUint(*buffer_view, "byteOffset", 0);
+  const auto view_size_in_bytes = GetGltfUint(*buffer_view, "byteLength", 0);
+  const auto accessor_offset = GetGltfUint(*accessor_json, "byteOffset", 0);
+  if (view_offset + view_size_in_bytes > buffer.size() || accessor_offset + stride_in_bytes * (count - 1) + element_size_in_bytes > view_size_in_bytes) { return false; }
+  *accessor = GltfAccessor{
+    .data = buffer.data() + view_offset + accessor_offset,
+    .count = static_cast<uint32_t>(count),
+    .stride_in_bytes = static_cast<uint32_t>(stride_in_bytes),
+    .component_type = static_cast<uint32_t>(component_type),
+    .component_num = GetGltfComponentNum(GetGltfString(*accessor_json, "type")),
+  };
+  return true;
+}
+auto GetGltfAttribute(const nlohmann::json& gltf, const std::vector<std::span<const uint8_t>>& buffers, const nlohmann::json& attributes, const char* const name, const uint32_t component_num, GltfAccessor* accessor) {
+  uint32_t accessor_index = 0;
+  if (!GetGltfIndex(attributes, name, &accessor_index) || !GetGltfAccessor(gltf, buffers, accessor_index, accessor)) {
+    logdebug("direct gltf import: no supported {}", name);
+    return false;
+  }
+  // e.g. quantized attributes of KHR_mesh_quantization
+  return accessor->component_type == kGltfComponentTypeFloat && accessor->component_num == component_num;
+}
+auto GetGltfIndexVal(const GltfAccessor& accessor, const uint32_t i) -> uint32_t {
+  const auto src = accessor.data + static_cast<std::size_t>(i) * accessor.stride_in_bytes;
+  switch (accessor.component_type) {
+    case kGltfComponentTypeUnsignedByte: return *src;
+    case kGltfComponentTypeUnsignedShort: {
+      uint16_t val = 0;
+      memcpy(&val, src, sizeof(val));
+      return val;
+    }
+  }
+  uint32_t val = 0;
+  memcpy(&val, src, sizeof(val));
+  return val;
+}
+void CopyGltfVec3(const GltfAccessor& accessor, aiVector3D* dst) {
+  if (accessor.stride_in_bytes == sizeof(aiVector3D)) {
+    memcpy(dst, accessor.data, accessor.count * sizeof(aiVector3D));
+    return;
+  }
+  for (uint32_t i = 0; i < accessor.count; i++) {
+    memcpy(&dst[i], accessor.data + static_cast<std::size_t>(i) * accessor.stride_in_bytes, sizeof(aiVector3D));
+  }
+}
+// as assimp/code/AssetLib/glTF2/glTF2Importer.cpp ImportMeshes followed by the steps the converter relies on
+// aiProcess_JoinIdenticalVertices for the attributes read from gltf. exact matches only, unreferenced vertices are dropped.
+void JoinGltfIdenticalVertices(aiMesh* mesh) {
+  const uint32_t kTriangleVertexNum = 3;
+  std::vector<uint32_t> indices(static_cast<std::size_t>(mesh->mNumFaces) * kTriangleVertexNum);
+  for (uint32_t i = 0; i < mesh->mNumFaces; i++) {
+    std::copy(mesh->mFaces[i].mIndices, mesh->mFaces[i].mIndices + kTriangleVertexNum, indices.begin() + i * kTriangleVertexNum);
+  }
+  aiVector3D** const streams[] = {&mesh->mVertices, &mesh->mNormals, &mesh->mTangents, &mesh->mBitangents, &mesh->mTextureCoords[0]};
+  meshopt_Stream meshopt_streams[std::size(streams)]{};
+  for (uint32_t i = 0; i < std::size(streams); i++) {
+    meshopt_streams[i] = {*streams[i], sizeof(aiVector3D), sizeof(aiVector3D)};
+  }
+  std::vector<uint32_t> remap(mesh->mNumVertices);
+  const auto vertex_num = GetUint32(meshopt_generateVertexRemapMulti(remap.data(), indices.data(), indices.size(), mesh->mNumVertices, meshopt_streams, std::size(meshopt_streams)));
+  if (vertex_num == mesh->mNumVertices) { return; }
+  for (auto* const stream : streams) {
+    auto remapped = new aiVector3D[vertex_num];
+    meshopt_remapVertexBuffer(remapped, *stream, mesh->mNumVertices, sizeof(aiVector3D), remap.data());
+    delete[] *stream;
+    *stream = remapped;
+  }
+  for (uint32_t i = 0; i < mesh->mNumFaces; i++) {
+    for (uint32_t j = 0; j < kTriangleVertexNum; j++) {
+      mesh->mFaces[i].mIndices[j] = remap[mesh->mFaces[i].mIndices[j]];
+    }
+  }
+  mesh->mNumVertices = vertex_num;
+}
+auto CreateGltfMesh(const nlohmann::json& gltf, const std::vector<std::span<const uint8_t>>& buffers, const nlohmann::json& primitive, const uint32_t post_process_steps) -> std::unique_ptr<aiMesh> {
+  if (GetGltfUint(primitive, "mode", kGltfModeTriangles) != kGltfModeTriangles || !primitive.contains("attributes")) {
+    logdebug("direct gltf import: primitive mode {}", GetGltfUint(primitive, "mode", kGltfModeTriangles));
+    return nullptr;
+  }
+  // normals and tangents are not generated here, GenSmoothNormals and CalcTangentSpace are left to assimp
+  const auto& attributes = primitive["attributes"];
+  GltfAccessor position, normal, tangent, texcoord;
+  if (!GetGltfAttribute(gltf, buffers, attributes, "POSITION", 3, &position)
+      || !GetGltfAttribute(gltf, buffers, attributes, "NORMAL", 3, &normal)
+      || !GetGltfAttribute(gltf, buffers, attributes, "TANGENT", 4, &tangent)
+      || !GetGltfAttribute(gltf, buffers, attributes, "TEXCOORD_0", 2, &texcoord)) {
+    return nullptr;
+  }
+  if (normal.count != position.count || tangent.count != position.count || texcoord.count != position.count) { return nullptr; }
+  const uint32_t kTriangleVertexNum = 3;
+  GltfAccessor indices{.count = position.count};
+  if (uint32_t accessor_index = 0; GetGltfIndex(primitive, "indices", &accessor_index)) {
+    if (!GetGltfAccessor(gltf, buffers, accessor_index, &indices) || indices.component_type == kGltfComponentTypeFloat || indices.component_num != 1) { return nullptr; }
+  }
+  if (indices.count % kTriangleVertexNum != 0) { return nullptr; }
+  auto mesh = std::make_unique<aiMesh>();
+  mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+  mesh->mNumVertices = position.count;
+  mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+  mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+  mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+  mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+  mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+  mesh->mNumUVComponents[0] = 2;
+  CopyGltfVec3(position, mesh->mVertices);
+  CopyGltfVec3(normal, mesh->mNormals);
+  for (uint32_t i = 0; i < mesh->mNumVertices; i++) {
+    float tangent_xyzw[4]{};
+    memcpy(tangent_xyzw, tangent.data + static_cast<std::size_t>(i) * tangent.stride_in_bytes, sizeof(tangent_xyzw));
+    mesh->mTangents[i] = aiVector3D(tangent_xyzw[0], tangent_xyzw[1], tangent_xyzw[2]);
+    mesh->mBitangents[i] = (mesh->mNormals[i] ^ mesh->mTangents[i]) * tangent_xyzw[3];
+    float uv[2]{};
+    memcpy(uv, texcoord.data + static_cast<std::size_t>(i) * texcoord.stride_in_bytes, sizeof(uv));
+    // flipped by the importer itself, not by aiProcess_FlipUVs
+    mesh->mTextureCoords[0][i] = aiVector3D(uv[0], 1.0f - uv[1], 0.0f);
+  }
+  mesh->mNumFaces = indices.count / kTriangleVertexNum;
+  mesh->mFaces = new aiFace[mesh->mNumFaces];
+  for (uint32_t i = 0; i < mesh->mNumFaces; i++) {
+    uint32_t triangle[kTriangleVertexNum]{};
+    for (uint32_t j = 0; j < kTriangleVertexNum; j++) {
+      const auto index = i * kTriangleVertexNum + j;
+      triangle[j] = indices.data == nullptr ? index : GetGltfIndexVal(indices, index);
+      if (triangle[j] >= mesh->mNumVertices) { return nullptr; }
+    }
+    if ((post_process_steps & aiProcess_FlipWindingOrder) != 0) {
+      std::swap(triangle[0], triangle[2]);
+    }
+    auto& face = mesh->mFaces[i];
+    face.mNumIndices = kTriangleVertexNum;
+    face.mIndices = new unsigned int[kTriangleVertexNum]{triangle[0], triangle[1], triangle[2]};
+  }
+  if ((post_process_steps & aiProcess_MakeLeftHanded) != 0) {
+    for (uint32_t i = 0; i < mesh->mNumVertices; i++) {
+      mesh->mVertices[i].z = -mesh->mVertices[i].z;
+      mesh->mNormals[i].z = -mesh->mNormals[i].z;
+      mesh->mTangents[i].z = -mesh->mTangents[i].z;
+      mesh->mBitangents[i].z = -mesh->mBitangents[i].z;
+    }
+  }
+  if ((post_process_steps & aiProcess_JoinIdenticalVertices) != 0) {
+    JoinGltfIdenticalVertices(mesh.get());
+  }
+  return mesh;
+}
+auto GetGltfMapMode(const uint64_t wrap) {
+  switch (wrap) {
+    case kGltfWrapClampToEdge: return aiTextureMapMode_Clamp;
+    case kGltfWrapMirroredRepeat: return aiTextureMapMode_Mirror;
+  }
+  return aiTextureMapMode_Wrap;
+}
+// properties read by GetTextureSlot, false for images assimp would embed and textures without image
+auto AddGltfTexture(const nlohmann::json& gltf, const nlohmann::json& texture_info, const aiTextureType texture_type, aiMaterial* material) {
+  uint32_t texture_index = 0, image_index = 0;
+  if (!GetGltfIndex(texture_info, "index", &texture_index)) { return false; }
+  const auto texture = GetGltfElement(gltf, "textures", texture_index);
+  if (texture == nullptr || !GetGltfIndex(*texture, "source", &image_index)) { return false; }
+  const auto image = GetGltfElement(gltf, "images", image_index);
+  const auto uri = image == nullptr ? std::string() : GetGltfString(*image, "uri");
+  if (uri.empty() || uri.starts_with("data:")) {
+    logdebug("direct gltf import: embedded image {}", image_index);
+    return false;
+  }
+  const aiString path(uri);
+  material->AddProperty(&path, AI_MATKEY_TEXTURE(texture_type, 0));
+  const auto uv_index = static_cast<int>(GetGltfUint(texture_info, "texCoord", 0));
+  material->AddProperty(&uv_index, 1, AI_MATKEY_UVWSRC(texture_type, 0));
+  const nlohmann::json* sampler = nullptr;
+  if (uint32_t sampler_index = 0; GetGltfIndex(*texture, "sampler", &sampler_index)) {
+    sampler = GetGltfElement(gltf, "samplers", sampler_index);
+    if (sampler == nullptr) { return false; }
+  }
+  const auto empty_sampler = nlohmann::json::object();
+  if (sampler == nullptr) { sampler = &empty_sampler; }
+  const aiTextureMapMode mapmode[] = {GetGltfMapMode(GetGltfUint(*sampler, "wrapS", 0)), GetGltfMapMode(GetGltfUint(*sampler, "wrapT", 0))};
+  material->AddProperty(&mapmode[0], 1, AI_MATKEY_MAPPINGMODE_U(texture_type, 0));
+  material->AddProperty(&mapmode[1], 1, AI_MATKEY_MAPPINGMODE_V(texture_type, 0));
+  if (const auto mag_filter = static_cast<uint32_t>(GetGltfUint(*sampler, "magFilter", SamplerFilter_UNSET)); mag_filter != SamplerFilter_UNSET) {
+    material->AddProperty(&mag_filter, 1, AI_MATKEY_GLTF_MAPPINGFILTER_MAG(texture_type, 0));
+  }
+  if (const auto min_filter = static_cast<uint32_t>(GetGltfUint(*sampler, "minFilter", SamplerFilter_UNSET)); min_filter != SamplerFilter_UNSET) {
+    material->AddProperty(&min_filter, 1, AI_MATKEY_GLTF_MAPPINGFILTER_MIN(texture_type, 0));
+  }
+  return true;
+}
+// properties read by CreateMaterialData, as assimp/code/AssetLib/glTF2/glTF2Importer.cpp ImportMaterial
+auto CreateGltfMaterial(const nlohmann::json& gltf, const nlohmann::json& material_json) -> std::unique_ptr<aiMaterial> {
+  auto material = std::make_unique<aiMaterial>();
+  if (const auto name = GetGltfString(material_json, "name"); !name.empty()) {
+    const aiString name_str(name);
+    material->AddProperty(&name_str, AI_MATKEY_NAME);
+  }
+  const int shading_mode = aiShadingMode_PBR_BRDF;
+  material->AddProperty(&shading_mode, 1, AI_MATKEY_SHADING_MODEL);
+  const auto empty = nlohmann::json::object();
+  const auto& pbr = material_json.contains("pbrMetallicRoughness") ? material_json["pbrMetallicRoughness"] : empty;
+  float base_color_factor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  GetGltfFloats(pbr, "baseColorFactor", base_color_factor);
+  const aiColor4D base_color(base_color_factor[0], base_color_factor[1], base_color_factor[2], base_color_factor[3]);
+  material->AddProperty(&base_color, 1, AI_MATKEY_BASE_COLOR);
+  const auto metallic_factor = GetGltfFloat(pbr, "metallicFactor", 1.0f);
+  const auto roughness_factor = GetGltfFloat(pbr, "roughnessFactor", 1.0f);
+  material->AddProperty(&metallic_factor, 1, AI_MATKEY_METALLIC_FACTOR);
+  material->AddProperty(&roughness_factor, 1, AI_MATKEY_ROUGHNESS_FACTOR);
+  float emissive_factor[3] = {0.0f, 0.0f, 0.0f};
+  GetGltfFloats(material_json, "emissiveFactor", emissive_factor);
+  const aiColor4D emissive(emissive_factor[0], emissive_factor[1], emissive_factor[2], 1.0f);
+  material->AddProperty(&emissive, 1, AI_MATKEY_COLOR_EMISSIVE);
+  const auto double_sided = material_json.contains("doubleSided") && material_json["doubleSided"].is_boolean() && material_json["doubleSided"].get<bool>();
+  material->AddProperty(&double_sided, 1, AI_MATKEY_TWOSIDED);
+  const auto alpha_mode_str = GetGltfString(material_json, "alphaMode");
+  const aiString alpha_mode(alpha_mode_str.empty() ? "OPAQUE" : alpha_mode_str);
+  material->AddProperty(&alpha_mode, AI_MATKEY_GLTF_ALPHAMODE);
+  const auto alpha_cutoff = GetGltfFloat(material_json, "alphaCutoff", 0.5f);
+  material->AddProperty(&alpha_cutoff, 1, AI_MATKEY_GLTF_ALPHACUTOFF);
+  const struct {
+    const nlohmann::json& parent;
+    const char* key;
+    aiTextureType type;
+  } textures[] = {
+    {pbr, "baseColorTexture", aiTextureType_BASE_COLOR},
+    {pbr, "metallicRoughnessTexture", aiTextureType_UNKNOWN},
+    {material_json, "normalTexture", aiTextureType_NORMALS},
+    {material_json, "occlusionTexture", aiTextureType_LIGHTMAP},
+    {material_json, "emissiveTexture", aiTextureType_EMISSIVE},
+  };
+  for (const auto& texture : textures) {
+    if (!texture.parent.contains(texture.key)) { continue; }
+    if (!AddGltfTexture(gltf, texture.parent[texture.key], texture.type, material.get())) { return nullptr; }
+  }
+  // only stored with their texture as assimp does
+  if (material_json.contains("normalTexture")) {
+    const auto scale = GetGltfFloat(material_json["normalTexture"], "scale", 1.0f);
+    material->AddProperty(&scale, 1, AI_MATKEY_GLTF_TEXTURE_SCALE(aiTextureType_NORMALS, 0));
+  }
+  if (material_json.contains("occlusionTexture")) {
+    const auto strength = GetGltfFloat(material_json["occlusionTexture"], "strength", 1.0f);
+    material->AddProperty(&strength, 1, AI_MATKEY_GLTF_TEXTURE_STRENGTH(aiTextureType_LIGHTMAP, 0));
+  }
+  return material;
+}
+auto GetGltfNodeTransform(const nlohmann::json& node) {
+  aiMatrix4x4 transform;
+  if (float matrix[16]{}; GetGltfFloats(node, "matrix", matrix)) {
+    // column major
+    for (uint32_t row = 0; row < 4; row++) {
+      for (uint32_t column = 0; column < 4; column++) {
+        transform[row][column] = matrix[column * 4 + row];
+      }
+    }
+    return transform;
+  }
+  float translation[3] = {0.0f, 0.0f, 0.0f};
+  float rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f}; // xyzw
+  float scale[3] = {1.0f, 1.0f, 1.0f};
+  GetGltfFloats(node, "translation", translation);
+  GetGltfFloats(node, "rotation", rotation);
+  GetGltfFloats(node, "scale", scale);
+  return aiMatrix4x4(aiVector3D(scale[0], scale[1], scale[2]), aiQuaternion(rotation[3], rotation[0], rotation[1], rotation[2]), aiVector3D(translation[0], translation[1], translation[2]));
+}
+// mesh_offsets[i] is the first aiMesh (primitive) of gltf mesh i, with the total mesh num appended
+auto CreateGltfNode(const nlohmann::json& gltf, const nlohmann::json& node_index, const std::vector<uint32_t>& mesh_offsets, const uint32_t post_process_steps, const uint32_t depth) -> std::unique_ptr<aiNode> {
+  const auto node_json = node_index.is_number_unsigned() ? GetGltfElement(gltf, "nodes", node_index.get<uint32_t>()) : nullptr;
+  // deeper than the node num only with a cycle
+  if (node_json == nullptr || depth > gltf["nodes"].size()) { return nullptr; }
+  auto node = std::make_unique<aiNode>(GetGltfString(*node_json, "name"));
+  node->mTransformation = GetGltfNodeTransform(*node_json);
+  if ((post_process_steps & aiProcess_MakeLeftHanded) != 0) {
+    // mirrored at z on both sides as aiProcess_MakeLeftHanded does
+    auto& m = node->mTransformation;
+    m.c1 = -m.c1;
+    m.c2 = -m.c2;
+    m.c4 = -m.c4;
+    m.a3 = -m.a3;
+    m.b3 = -m.b3;
+    m.d3 = -m.d3;
+  }
+  if (uint32_t mesh_index = 0; GetGltfIndex(*node_json, "mesh", &mesh_index)) {
+    if (mesh_index + 1 >= mesh_offsets.size()) { return nullptr; }
+    node->mNumMeshes = mesh_offsets[mesh_index + 1] - mesh_offsets[mesh_index];
+    node->mMeshes = new unsigned int[node->mNumMeshes];
+    std::iota(node->mMeshes, node->mMeshes + node->mNumMeshes, mesh_offsets[mesh_index]);
+  }
+  if (node_json->contains("children")) {
+    const auto& children = (*node_json)["children"];
+    node->mChildren = new aiNode*[children.size()];
+    for (const auto& child_index : children) {
+      auto child = CreateGltfNode(gltf, child_index, mesh_offsets, post_process_steps, depth + 1);
+      if (child == nullptr) { return nullptr; }
+      child->mParent = node.get();
+      node->mChildren[node->mNumChildren] = child.release();
+      node->mNumChildren++;
+    }
+  }
+  return node;
+}
+// scene assimp would give for the file followed by post_process_steps (a subset of kDirectGltfImportPostProcessSteps), built from accessors in place.
+// nullptr if anything needs assimp, e.g. missing normals/tangents/texcoords, non triangle primitives, sparse accessors or embedded images.
+auto CreateGltfScene(const std::span<const uint8_t> file, const char* const input_directory, const uint32_t post_process_steps) -> std::unique_ptr<aiScene> {
+  nlohmann::json gltf;
+  std::span<const uint8_t> bin_chunk;
+  if (!ParseGltfFile(file, &gltf, &bin_chunk) || !HasOnlyIgnorableGltfExtensions(gltf)) { return nullptr; }
+  // buffers stay mapped until accessors are copied to the scene
+  std::vector<std::unique_ptr<MappedFile>> mapped_files;
+  std::vector<std::span<const uint8_t>> buffers;
+  if (!MapGltfBuffers(gltf, bin_chunk, input_directory, &mapped_files, &buffers)) { return nullptr; }
+  // the default material for primitives without one is appended as assimp does
+  std::vector<std::unique_ptr<aiMaterial>> materials;
+  if (gltf.contains("materials")) {
+    for (const auto& material_json : gltf["materials"]) {
+      materials.push_back(CreateGltfMaterial(gltf, material_json));
+      if (materials.back() == nullptr) { return nullptr; }
+    }
+  }
+  const auto default_material_index = static_cast<uint32_t>(materials.size());
+  materials.push_back(CreateGltfMaterial(gltf, nlohmann::json::object()));
+  // one aiMesh per primitive
+  std::vector<std::unique_ptr<aiMesh>> meshes;
+  std::vector<uint32_t> mesh_offsets;
+  if (gltf.contains("meshes")) {
+    for (const auto& mesh_json : gltf["meshes"]) {
+      mesh_offsets.push_back(static_cast<uint32_t>(meshes.size()));
+      if (!mesh_json.contains("primitives")) { continue; }
+      const auto name = GetGltfString(mesh_json, "name");
+      const auto& primitives = mesh_json["primitives"];
+      for (uint32_t i = 0; i < primitives.size(); i++) {
+        auto mesh = CreateGltfMesh(gltf, buffers, primitives[i], post_process_steps);
+        if (mesh == nullptr) { return nullptr; }
+        mesh->mName = aiString(primitives.size() > 1 ? fmt::format("{}-{}", name, i) : name);
+        uint32_t material_index = 0;
+        mesh->mMaterialIndex = (GetGltfIndex(primitives[i], "material", &material_index) && material_index < default_material_index) ? material_index : default_material_index;
+        meshes.push_back(std::move(mesh));
+      }
+    }
+  }
+  mesh_offsets.push_back(static_cast<uint32_t>(meshes.size()));
+  uint32_t scene_index = 0;
+  GetGltfIndex(gltf, "scene", &scene_index);
+  const auto scene_json = GetGltfElement(gltf, "scenes", scene_index);
+  if (scene_json == nullptr || !scene_json->contains("nodes")) { return nullptr; }
+  const auto& root_nodes = (*scene_json)["nodes"];
+  auto root_node = std::make_unique<aiNode>("root");
+  root_node->mChildren = new aiNode*[root_nodes.size()];
+  for (const auto& node_index : root_nodes) {
+    auto node = CreateGltfNode(gltf, node_index, mesh_offsets, post_process_steps, 0);
+    if (node == nullptr) { return nullptr; }
+    node->mParent = root_node.get();
+    root_node->mChildren[root_node->mNumChildren] = node.release();
+    root_node->mNumChildren++;
+  }
+  auto scene = std::make_unique<aiScene>();
+  scene->mRootNode = root_node.release();
+  scene->mNumMaterials = static_cast<uint32_t>(materials.size());
+  scene->mMaterials = new aiMaterial*[scene->mNumMaterials];
+  for (uint32_t i = 0; i < scene->mNumMaterials; i++) {
+    scene->mMaterials[i] = materials[i].release();
+  }
+  scene->mNumMeshes = static_cast<uint32_t>(meshes.size());
+  scene->mMeshes = new aiMesh*[scene->mNumMeshes];
+  for (uint32_t i = 0; i < scene->mNumMeshes; i++) {
+    scene->mMeshes[i] = meshes[i].release();
+  }
+  return scene;
+}
+// the default preset. steps added on top of the fast preset are handled as follows for gltf the direct import accepts:
+// - JoinIdenticalVertices: applied by CreateGltfMesh
+// - ValidateDataStructure: accessor and index ranges are validated while building the scene
+// - GenUVCoords: gltf textures always use uv mapping, no-op
+// - Debone: skins are not imported, no-op
+// - FixInfacingNormals, FindInvalidData: gltf requires finite unit length normals, no-op for valid files
+// - FindInstances: gltf instances meshes by node references, duplicate meshes are kept
+// - RemoveRedundantMaterials: identical materials are merged by CreateJsonMaterialList
+// any other step (e.g. FindDegenerates and OptimizeMeshes in the thorough preset) needs a scene imported by assimp.
+const uint32_t kDirectGltfImportPostProcessSteps = kDefaultPostProcessSteps;
+auto IsDirectGltfImportApplicable(const Options& options, const uint32_t post_process_steps, const bool is_gltf) {
+  return options.direct_gltf_import && is_gltf && (post_process_steps & ~kDirectGltfImportPostProcessSteps) == 0;
+}
+auto ImportGltfScene(const char* const input_filepath, const uint32_t post_process_steps, ConversionMetrics* metrics) {
+  return MeasureStage("direct gltf import", metrics, [&]() {
+    const MappedFile file(input_filepath);
+    const auto input_directory = std::filesystem::path(input_filepath).parent_path().string();
+    auto scene = CreateGltfScene(file.GetData(), input_directory.c_str(), post_process_steps);
+    if (scene == nullptr) { loginfo("direct gltf import not applicable, using assimp. {}", input_filepath); }
+    return scene;
+  });
+}
+auto ImportGltfSceneFromMemory(const void* const data, const std::size_t size_in_bytes, const uint32_t post_process_steps, ConversionMetrics* metrics) {
+  return MeasureStage("direct gltf import", metrics, [&]() {
+    auto scene = CreateGltfScene(std::span<const uint8_t>(static_cast<const uint8_t*>(data), size_in_bytes), nullptr, post_process_steps);
+    if (scene == nullptr) { loginfo("direct gltf import not applicable, using assimp."); }
+    return scene;
+  });
+}
+auto IsConvertibleScene(const aiScene* scene) {
+  return scene != nullptr && (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) == 0 && scene->HasMeshes() && scene->mRootNode != nullptr;
+}
+// the importer is not used for direct imports, its error string may be left from a previous file then
+void LogImportError(const char* const name, const bool is_direct_import, const Assimp::Importer& importer) {
+  if (is_direct_import) {
+    logerror("failed to load scene. {} direct gltf import has no mesh or node", name);
+    return;
+  }
+  logerror("failed to load scene. {} {}", name, importer.GetErrorString());
+}
+// index and vertex offsets are 32-bit element counts in the container (byte offsets are 64-bit)
+auto IsWithinElementRange(const aiScene& scene, const Options& options) {
+  const uint64_t kTriangleVertexNum = 3;
+  const uint64_t kMaxElementNum = std::numeric_limits<uint32_t>::max();
+  uint64_t index_num = 0, vertex_num = 0;
+  for (uint32_t i = 0; i < scene.mNumMeshes; i++) {
+    index_num += scene.mMeshes[i]->mNumFaces * kTriangleVertexNum;
+    vertex_num += scene.mMeshes[i]->mNumVertices;
+  }
+  // lods are appended to the lod0 index buffer. simplification stops at lod_target_error,
+  // so a lod is only guaranteed to be smaller than lod0, not to reach its target ratio.
+  index_num *= 1 + options.lod_target_ratios.size();
+  if (index_num > kMaxElementNum || vertex_num > kMaxElementNum) {
+    logerror("index num {} or vertex num {} exceeds {}", index_num, vertex_num, kMaxElementNum);
+    return false;
+  }
+  return true;
+}
+// section buffers point to local data, only their layout is valid after return
+auto OutputContainer(const aiScene& scene,
+                     const Options& options,
+                     const std::vector<float>& transform_matrix_list,
+                     const std::vector<uint32_t>& transform_index_list_offset,
+                     const std::vector<uint32_t>& transform_index_list,
+                     const nlohmann::json& material_settings,
+                     std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set,
+                     ContainerTables* tables,
+                     const char* const filename,
+                     std::vector<uint8_t>* container,
+                     ConversionMetrics* metrics) {
+  auto mesh_buffers = MeasureStage("gather", metrics, [&]() { return GatherMeshData(options.thread_num, scene.mNumMeshes, scene.mMeshes, per_draw_call_model_index_set); });
+  if (options.optimize_mesh) {
+    MeasureStage("optimize", metrics, [&]() { OptimizeMeshes(options.thread_num, *per_draw_call_model_index_set, &mesh_buffers); });
+  }
+  if (!options.lod_target_ratios.empty()) {
+    MeasureStage("lod", metrics, [&]() { BuildLods(options.lod_target_ratios, options.lod_target_error, &mesh_buffers, per_draw_call_model_index_set); });
+  }
+  MeshletBuffers meshlet_buffers;
+  if (options.build_meshlets) {
+    meshlet_buffers = MeasureStage("meshlet", metrics, [&]() { return BuildMeshlets(options.meshlet_max_vertices, options.meshlet_max_triangles, mesh_buffers, per_draw_call_model_index_set); });
+  }
+  QuantizedMeshBuffers quantized_mesh_buffers;
+  if (options.quantize_vertex) {
+    quantized_mesh_buffers = MeasureStage("quantize", metrics, [&]() { return QuantizeMeshBuffers(options.quantize_position, options.texcoord_unorm16, mesh_buffers, per_draw_call_model_index_set); });
+  }
+  const auto quantized_mesh_buffers_ptr = options.quantize_vertex ? &quantized_mesh_buffers : nullptr;
+  std::vector<uint8_t> narrowed_index_buffer;
+  std::vector<uint8_t> interleaved_vertex_buffer;
+  const auto sections = MeasureStage("layout", metrics, [&]() {
+    const auto index_stream = CreateIndexStream(options.narrow_index_buffer, options.group_streams_per_mesh, mesh_buffers.index_buffer, &narrowed_index_buffer, per_draw_call_model_index_set);
+    const auto vertex_streams = CreateVertexStreams(options.vertex_layout, CreateSeparateVertexStreams(mesh_buffers, quantized_mesh_buffers_ptr), &interleaved_vertex_buffer);
+    return CreateSectionList(options.section_alignment, container != nullptr ? 0 : options.chunk_size_in_bytes, options.group_streams_per_mesh, transform_matrix_list, transform_index_list_offset, transform_index_list, index_stream, vertex_streams, meshlet_buffers, material_settings, per_draw_call_model_index_set, tables);
+  });
+  MeasureStage("write", metrics, [&]() {
+    if (container != nullptr) {
+      OutputContainerToMemory(options.section_alignment, sections, container);
+    } else {
+      OutputContainerToFile(options.section_alignment, sections, filename);
+    }
+  });
+  return sections;
+}
+auto CountMeshMetrics(const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set, ConversionMetrics* metrics) {
+  for (const auto& mesh : per_draw_call_model_index_set) {
+    if (mesh.index_buffer_len == 0) { continue; }
+    metrics->mesh_num++;
+    metrics->vertex_num += mesh.vertex_num;
+    metrics->triangle_num += mesh.index_buffer_len / 3;
+  }
+}
+auto GetOutputSizeInBytes(const char* const output_directory, const std::vector<std::string>& output_files) {
+  uint64_t size_in_bytes = 0;
+  for (const auto& filename : output_files) {
+    std::error_code error;
+    const auto file_size = std::filesystem::file_size(std::filesystem::path(output_directory) / filename, error);
+    if (!error) {
+      size_in_bytes += file_size;
+    }
+  }
+  return size_in_bytes;
+}
+// chrome trace event format (chrome://tracing, perfetto), counters are also in otherData for dashboards
+auto CreateTraceJson(const char* const input_filepath, const ConversionMetrics& metrics) {
+  const double kUsPerMs = 1000.0;
+  auto events = nlohmann::json::array();
+  for (const auto& stage : metrics.stages) {
+    nlohmann::json event;
+    event["name"] = stage.name;
+    event["cat"] = "modelconv";
+    event["ph"] = "X";
+    event["ts"] = stage.start_ms * kUsPerMs;
+    event["dur"] = stage.elapsed_ms * kUsPerMs;
+    event["pid"] = 0;
+    event["tid"] = 0;
+    events.push_back(event);
+  }
+  nlohmann::json counters;
+  counters["mesh_num"] = metrics.mesh_num;
+  counters["vertex_num"] = metrics.vertex_num;
+  counters["triangle_num"] = metrics.triangle_num;
+  counters["bytes_written"] = metrics.bytes_written;
+  counters["peak_rss_in_bytes"] = metrics.peak_rss_in_bytes;
+  nlohmann::json counter_event;
+  counter_event["name"] = "counters";
+  counter_event["ph"] = "C";
+  counter_event["ts"] = metrics.stages.empty() ? 0.0 : (metrics.stages.back().start_ms + metrics.stages.back().elapsed_ms) * kUsPerMs;
+  counter_event["pid"] = 0;
+  counter_event["args"] = counters;
+  events.push_back(counter_event);
+  auto other_data = counters;
+  other_data["input"] = input_filepath;
+  other_data["converter_version"] = kConverterVersion;
+  other_data["total_ms"] = GetElapsedMs(metrics.start);
+  nlohmann::json json;
+  json["traceEvents"] = std::move(events);
+  json["displayTimeUnit"] = "ms";
+  json["otherData"] = std::move(other_data);
+  return json;
+}
+struct StaticMeshPart {
+  uint32_t mesh_index{0};
+  aiMatrix4x4 transform;
+};
+struct StaticBatch {
+  uint32_t material_index{0};
+  uint32_t vertex_num{0};
+  std::vector<StaticMeshPart> parts;
+};
+struct NodeMeshes {
+  aiMatrix4x4 transform; // global
+  std::vector<uint32_t> mesh_indices;
+};
+void CollectNodeMeshes(const aiNode* node, const aiMatrix4x4& parent_transform, std::vector<NodeMeshes>* node_meshes_list, std::vector<uint32_t>* instance_num_list) {
+  auto transform = parent_transform;
+  transform *= node->mTransformation;
+  if (node->mNumMeshes > 0) {
+    node_meshes_list->push_back(NodeMeshes{.transform = transform, .mesh_indices = std::vector<uint32_t>(node->mMeshes, node->mMeshes + node->mNumMeshes)});
+    for (uint32_t i = 0; i < node->mNumMeshes; i++) {
+      (*instance_num_list)[node->mMeshes[i]]++;
+    }
+  }
+  for (uint32_t i = 0; i < node->mNumChildren; i++) {
+    CollectNodeMeshes(node->mChildren[i], transform, node_meshes_list, instance_num_list);
+  }
+}
+auto TransformDirection(const aiMatrix3x3& matrix, const aiVector3D& direction) {
+  auto transformed = matrix * direction;
+  return transformed.Normalize();
+}
+// single mesh with transforms of all parts baked into vertices
+auto CreateStaticBatchMesh(const aiScene& scene, const StaticBatch& batch) {
+  auto mesh = new aiMesh;
+  mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+  mesh->mMaterialIndex = batch.material_index;
+  mesh->mName = aiString(fmt::format("static_batch_material{}", batch.material_index));
+  mesh->mNumVertices = batch.vertex_num;
+  mesh->mVertices = new aiVector3D[batch.vertex_num];
+  mesh->mNormals = new aiVector3D[batch.vertex_num];
+  mesh->mTangents = new aiVector3D[batch.vertex_num];
+  mesh->mBitangents = new aiVector3D[batch.vertex_num];
+  mesh->mTextureCoords[0] = new aiVector3D[batch.vertex_num];
+  mesh->mNumUVComponents[0] = 2;
+  for (const auto& part : batch.parts) {
+    mesh->mNumFaces += scene.mMeshes[part.mesh_index]->mNumFaces;
+  }
+  mesh->mFaces = new aiFace[mesh->mNumFaces];
+  uint32_t vertex_offset = 0;
+  uint32_t face_offset = 0;
+  for (const auto& part : batch.parts) {
+    const auto& src = *scene.mMeshes[part.mesh_index];
+    const auto normal_matrix = aiMatrix3x3(part.transform).Inverse().Transpose();
+    const auto direction_matrix = aiMatrix3x3(part.transform);
+    for (uint32_t i = 0; i < src.mNumVertices; i++) {
+      const auto dst = vertex_offset + i;
+      mesh->mVertices[dst] = part.transform * src.mVertices[i];
+      mesh->mNormals[dst] = TransformDirection(normal_matrix, src.mNormals[i]);
+      mesh->mTangents[dst] = TransformDirection(direction_matrix, src.mTangents[i]);
+      mesh->mBitangents[dst] = TransformDirection(direction_matrix, src.mBitangents[i]);
+      mesh->mTextureCoords[0][dst] = src.HasTextureCoords(0) ? src.mTextureCoords[0][i] : aiVector3D();
+    }
+    // mirroring transforms flip the winding order
+    const auto flip_winding = part.transform.Determinant() < 0.0f;
+    for (uint32_t i = 0; i < src.mNumFaces; i++) {
+      const auto& src_face = src.mFaces[i];
+      auto& face = mesh->mFaces[face_offset + i];
+      face.mNumIndices = src_face.mNumIndices;
+      face.mIndices = new unsigned int[src_face.mNumIndices];
+      for (uint32_t j = 0; j < src_face.mNumIndices; j++) {
+        face.mIndices[j] = src_face.mIndices[flip_winding ? src_face.mNumIndices - 1 - j : j] + vertex_offset;
+      }
+    }
+    vertex_offset += src.mNumVertices;
+    face_offset += src.mNumFaces;
+  }
+  return mesh;
+}
+// meshes not marked as owned, materials and textures belong to the source scene
+struct BorrowingSceneDeleter {
+  std::vector<bool> owned_meshes;
+  void operator()(aiScene* scene) const {
+    for (uint32_t i = 0; i < scene->mNumMeshes; i++) {
+      if (!owned_meshes[i]) { scene->mMeshes[i] = nullptr; }
+    }
+    std::fill(scene->mMaterials, scene->mMaterials + scene->mNumMaterials, nullptr);
+    if (scene->mTextures != nullptr) {
+      std::fill(scene->mTextures, scene->mTextures + scene->mNumTextures, nullptr);
+    }
+    delete scene;
+  }
+};
+using BorrowingScene = std::unique_ptr<aiScene, BorrowingSceneDeleter>;
+// scene with given meshes and nodes under a new root, materials and textures of the source scene are borrowed
+auto CreateBorrowingScene(const aiScene& scene, const std::vector<aiMesh*>& meshes, std::vector<bool>&& owned_meshes, const std::vector<aiNode*>& children) {
+  BorrowingScene borrowing_scene(new aiScene, BorrowingSceneDeleter{.owned_meshes = std::move(owned_meshes)});
+  borrowing_scene->mFlags = scene.mFlags;
+  borrowing_scene->mRootNode = new aiNode("root");
+  borrowing_scene->mRootNode->mNumChildren = GetUint32(children.size());
+  borrowing_scene->mRootNode->mChildren = new aiNode*[children.size()];
+  for (uint32_t i = 0; i < children.size(); i++) {
+    children[i]->mParent = borrowing_scene->mRootNode;
+    borrowing_scene->mRootNode->mChildren[i] = children[i];
+  }
+  borrowing_scene->mNumMeshes = GetUint32(meshes.size());
+  borrowing_scene->mMeshes = new aiMesh*[meshes.size()];
+  std::copy(meshes.begin(), meshes.end(), borrowing_scene->mMeshes);
+  borrowing_scene->mNumMaterials = scene.mNumMaterials;
+  borrowing_scene->mMaterials = new aiMaterial*[scene.mNumMaterials];
+  std::copy(scene.mMaterials, scene.mMaterials + scene.mNumMaterials, borrowing_scene->mMaterials);
+  if (scene.mNumTextures > 0) {
+    borrowing_scene->mNumTextures = scene.mNumTextures;
+    borrowing_scene->mTextures = new aiTexture*[scene.mNumTextures];
+    std::copy(scene.mTextures, scene.mTextures + scene.mNumTextures, borrowing_scene->mTextures);
+  }
+  return borrowing_scene;
+}
+// bakes transforms of meshes drawn only once into vertices and merges them per material up to max_vertex_num vertices per batch.
+// instanced meshes are kept as is, referenced from nodes with their global transform.
+auto CreateStaticBatchScene(const aiScene& scene, const uint32_t max_vertex_num) {
+  std::vector<NodeMeshes> node_meshes_list;
+  std::vector<uint32_t> instance_num_list(scene.mNumMeshes, 0);
+  CollectNodeMeshes(scene.mRootNode, aiMatrix4x4(), &node_meshes_list, &instance_num_list);
+  std::vector<StaticBatch> batches;
+  std::unordered_map<uint32_t, uint32_t> open_batch_per_material;
+  std::vector<uint32_t> batch_index_per_mesh(scene.mNumMeshes, kInvalidIndex);
+  for (const auto& node_meshes : node_meshes_list) {
+    for (const auto mesh_index : node_meshes.mesh_indices) {
+      const auto& mesh = *scene.mMeshes[mesh_index];
+      if (instance_num_list[mesh_index] != 1 || !IsValidMesh(mesh)) { continue; }
+      auto [it, inserted] = open_batch_per_material.try_emplace(mesh.mMaterialIndex, GetUint32(batches.size()));
+      if (!inserted && batches[it->second].vertex_num + mesh.mNumVertices > max_vertex_num) {
+        it->second = GetUint32(batches.size());
+        inserted = true;
+      }
+      if (inserted) {
+        batches.push_back(StaticBatch{.material_index = mesh.mMaterialIndex, .vertex_num = 0, .parts = {}});
+      }
+      auto& batch = batches[it->second];
+      batch.parts.push_back(StaticMeshPart{.mesh_index = mesh_index, .transform = node_meshes.transform});
+      batch.vertex_num += mesh.mNumVertices;
+      batch_index_per_mesh[mesh_index] = it->second;
+    }
+  }
+  std::vector<aiMesh*> meshes;
+  std::vector<bool> owned_meshes;
+  for (const auto& batch : batches) {
+    meshes.push_back(CreateStaticBatchMesh(scene, batch));
+    owned_meshes.push_back(true);
+  }
+  std::vector<uint32_t> mesh_index_remap(scene.mNumMeshes, kInvalidIndex);
+  for (uint32_t i = 0; i < scene.mNumMeshes; i++) {
+    if (batch_index_per_mesh[i] != kInvalidIndex) { continue; }
+    mesh_index_remap[i] = GetUint32(meshes.size());
+    meshes.push_back(scene.mMeshes[i]);
+    owned_meshes.push_back(false);
+  }
+  loginfo("static batch: {} meshes -> {} batches + {} meshes", scene.mNumMeshes, batches.size(), meshes.size() - batches.size());
+  // root with identity transform drawing all batches, one child per source node with remaining meshes
+  std::vector<aiNode*> children;
+  if (!batches.empty()) {
+    auto node = new aiNode("static_batches");
+    node->mNumMeshes = GetUint32(batches.size());
+    node->mMeshes = new unsigned int[node->mNumMeshes];
+    std::iota(node->mMeshes, node->mMeshes + node->mNumMeshes, 0U);
+    children.push_back(node);
+  }
+  for (const auto& node_meshes : node_meshes_list) {
+    std::vector<uint32_t> mesh_indices;
+    for (const auto mesh_index : node_meshes.mesh_indices) {
+      if (mesh_index_remap[mesh_index] == kInvalidIndex) { continue; }
+      mesh_indices.push_back(mesh_index_remap[mesh_index]);
+    }
+    if (mesh_indices.empty()) { continue; }
+    auto node = new aiNode(fmt::format("instances{}", children.size()));
+    node->mTransformation = node_meshes.transform;
+    node->mNumMeshes = GetUint32(mesh_indices.size());
+    node->mMeshes = new unsigned int[node->mNumMeshes];
+    std::copy(mesh_indices.begin(), mesh_indices.end(), node->mMeshes);
+    children.push_back(node);
+  }
+  return CreateBorrowingScene(scene, meshes, std::move(owned_meshes), children);
+}
+struct SpatialCell {
+  std::array<int32_t, 3> coord{};
+  float aabb_min[3]{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+  float aabb_max[3]{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+  uint32_t instance_num{0};
+  std::vector<NodeMeshes> node_meshes_list; // mesh indices of the source scene
+  uint32_t last_node_index{kInvalidIndex};
+};
+// instances are assigned to the cell containing the center of their world space bounds, cells are sorted by coord
+auto PartitionSceneToCells(const aiScene& scene, const float cell_size) {
+  std::vector<NodeMeshes> node_meshes_list;
+  std::vector<uint32_t> instance_num_list(scene.mNumMeshes, 0);
+  CollectNodeMeshes(scene.mRootNode, aiMatrix4x4(), &node_meshes_list, &instance_num_list);
+  std::vector<MeshBoundsEntry> mesh_bounds(scene.mNumMeshes);
+  for (uint32_t i = 0; i < scene.mNumMeshes; i++) {
+    mesh_bounds[i] = CreateMeshBounds(*scene.mMeshes[i]);
+  }
+  std::map<std::array<int32_t, 3>, SpatialCell> cells;
+  for (uint32_t i = 0; i < node_meshes_list.size(); i++) {
+    const auto& node_meshes = node_meshes_list[i];
+    for (const auto mesh_index : node_meshes.mesh_indices) {
+      if (!IsValidMesh(*scene.mMeshes[mesh_index])) { continue; }
+      InstanceBoundsEntry bounds{};
+      TransformBounds(&node_meshes.transform.a1, mesh_bounds[mesh_index], &bounds);
+      std::array<int32_t, 3> coord{};
+      for (uint32_t j = 0; j < 3; j++) {
+        coord[j] = static_cast<int32_t>(std::floor((bounds.aabb_min[j] + bounds.aabb_max[j]) * 0.5f / cell_size));
+      }
+      auto& cell = cells[coord];
+      cell.coord = coord;
+      if (cell.last_node_index != i) {
+        cell.node_meshes_list.push_back(NodeMeshes{.transform = node_meshes.transform, .mesh_indices = {}});
+        cell.last_node_index = i;
+      }
+      cell.node_meshes_list.back().mesh_indices.push_back(mesh_index);
+      cell.instance_num++;
+      for (uint32_t j = 0; j < 3; j++) {
+        cell.aabb_min[j] = std::min(cell.aabb_min[j], bounds.aabb_min[j]);
+        cell.aabb_max[j] = std::max(cell.aabb_max[j], bounds.aabb_max[j]);
+      }
+    }
+  }
+  std::vector<SpatialCell> cell_list;
+  cell_list.reserve(cells.size());
+  for (auto& [coord, cell] : cells) {
+    cell_list.push_back(std::move(cell));
+  }
+  return cell_list;
+}
+// meshes referenced in the cell are borrowed from the source scene, one node per source node with its global transform
+auto CreateCellScene(const aiScene& scene, const SpatialCell& cell) {
+  std::vector<aiMesh*> meshes;
+  std::vector<uint32_t> mesh_index_remap(scene.mNumMeshes, kInvalidIndex);
+  std::vector<aiNode*> children;
+  for (const auto& node_meshes : cell.node_meshes_list) {
+    auto node = new aiNode(fmt::format("instances{}", children.size()));
+    node->mTransformation = node_meshes.transform;
+    node->mNumMeshes = GetUint32(node_meshes.mesh_indices.size());
+    node->mMeshes = new unsigned int[node->mNumMeshes];
+    for (uint32_t i = 0; i < node->mNumMeshes; i++) {
+      const auto mesh_index = node_meshes.mesh_indices[i];
+      if (mesh_index_remap[mesh_index] == kInvalidIndex) {
+        mesh_index_remap[mesh_index] = GetUint32(meshes.size());
+        meshes.push_back(scene.mMeshes[mesh_index]);
+      }
+      node->mMeshes[i] = mesh_index_remap[mesh_index];
+    }
+    children.push_back(node);
+  }
+  return CreateBorrowingScene(scene, meshes, std::vector<bool>(meshes.size(), false), children);
+}
+auto GetCellFilename(const char* const basename, const SpatialCell& cell) {
+  return GetOutputFilename(basename, fmt::format("cell_{}_{}_{}.bin", cell.coord[0], cell.coord[1], cell.coord[2]).c_str());
+}
+// transforms, bounds and container of a scene whose materials are listed in material_settings
+auto OutputSceneContainer(const aiScene& scene,
+                          const std::vector<uint32_t>& material_index_remap,
+                          const nlohmann::json& material_settings,
+                          const Options& options,
+                          const char* const binary_filepath,
+                          std::vector<uint8_t>* container,
+                          std::vector<PerDrawCallModelIndexSet>* per_draw_call_model_index_set,
+                          ConversionMetrics* metrics) {
+  per_draw_call_model_index_set->resize(scene.mNumMeshes);
+  const auto transform_matrix_list = MeasureStage("transform", metrics, [&]() { return GetTransformMatrixList(scene.mRootNode, per_draw_call_model_index_set->data()); });
+  const auto [transform_index_list_offset, transform_index_list] = FlattenTransformIndexLists(*per_draw_call_model_index_set);
+  AssignMaterialIndices(scene.mNumMeshes, scene.mMeshes, material_index_remap, per_draw_call_model_index_set);
+  ContainerTables container_tables;
+  MeasureStage("bounds", metrics, [&]() {
+    CreateBoundsTables(options.thread_num, scene.mNumMeshes, scene.mMeshes, transform_matrix_list, transform_index_list_offset, transform_index_list, &container_tables);
+    if (options.build_bvh) {
+      BuildInstanceBvh(&container_tables);
+    }
+  });
+  if (options.streaming_write && container == nullptr) {
+    return OutputContainerStreaming(scene, options, transform_matrix_list, transform_index_list_offset, transform_index_list, material_settings, per_draw_call_model_index_set, &container_tables, binary_filepath, metrics);
+  }
+  return OutputContainer(scene, options, transform_matrix_list, transform_index_list_offset, transform_index_list, material_settings, per_draw_call_model_index_set, &container_tables, binary_filepath, container, metrics);
+}
+void WriteContainerJson(const std::vector<PerDrawCallModelIndexSet>& per_draw_call_model_index_set, const std::vector<BinaryStream>& sections, const nlohmann::json& material_settings, const Options& options, const char* const binary_filename, const char* const output_directory, ConversionMetrics* metrics, std::vector<std::string>* output_files) {
+  nlohmann::json json;
+  json["meshes"] = CreateMeshJson(per_draw_call_model_index_set);
+  json["binary_info"] = CreateJsonBinaryEntityList(options.section_alignment, sections);
+  json["binary_filename"] = binary_filename;
+  json["vertex_layout"] = GetVertexLayoutName(options.vertex_layout);
+  json["material_settings"] = material_settings;
+  const auto json_filename = std::filesystem::path(binary_filename).replace_extension(".json").generic_string();
+  MeasureStage("json", metrics, [&]() { WriteOutJson(json, GetOutputFilePath(output_directory, json_filename.c_str()).c_str()); });
+  output_files->push_back(json_filename);
+}
+auto PushContainerFilenames(const char* const binary_filename, const std::vector<BinaryStream>& sections, std::vector<std::string>* output_files) {
+  for (uint32_t i = 0; i < GetChunkNum(sections); i++) {
+    output_files->push_back(GetChunkFilename(binary_filename, i));
+  }
+}
+// one container per cell and an index container with kCell and material tables
+void OutputSpatialCells(const aiScene& scene, const std::vector<uint32_t>& material_index_remap, const nlohmann::json& material_settings, const Options& options, const char* const basename, const char* const output_directory, ConversionMetrics* metrics, std::vector<std::string>* output_files) {
+  const auto cells = MeasureStage("partition", metrics, [&]() { return PartitionSceneToCells(scene, options.spatial_cell_size); });
+  loginfo("spatial partition: {} cells of size {}", cells.size(), options.spatial_cell_size);
+  ContainerTables tables;
+  CreateMaterialTables(material_settings, &tables);
+  std::vector<CellEntry> cell_entries;
+  for (const auto& cell : cells) {
+    const auto cell_scene = CreateCellScene(scene, cell);
+    const auto cell_filename = GetCellFilename(basename, cell);
+    std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set;
+    const auto sections = OutputSceneContainer(*cell_scene, material_index_remap, material_settings, options, GetOutputFilePath(output_directory, cell_filename.c_str()).c_str(), nullptr, &per_draw_call_model_index_set, metrics);
+    PushContainerFilenames(cell_filename.c_str(), sections, output_files);
+    if (options.output_json) {
+      WriteContainerJson(per_draw_call_model_index_set, sections, material_settings, options, cell_filename.c_str(), output_directory, metrics, output_files);
+    }
+    CountMeshMetrics(per_draw_call_model_index_set, metrics);
+    CellEntry entry{};
+    std::copy(cell.coord.begin(), cell.coord.end(), entry.coord);
+    std::copy(std::begin(cell.aabb_min), std::end(cell.aabb_min), entry.aabb_min);
+    std::copy(std::begin(cell.aabb_max), std::end(cell.aabb_max), entry.aabb_max);
+    entry.path_offset = GetUint32(tables.strings.size());
+    entry.path_len = GetUint32(cell_filename.size());
+    entry.instance_num = cell.instance_num;
+    entry.file_size_in_bytes = GetChunkSizeInBytes(sections, 0);
+    entry.mesh_num = cell_scene->mNumMeshes;
+    entry.chunk_num = GetChunkNum(sections);
+    tables.strings.insert(tables.strings.end(), cell_filename.begin(), cell_filename.end());
+    cell_entries.push_back(entry);
+  }
+  std::vector<BinaryStream> sections;
+  sections.push_back(CreateBinaryStream(SectionType::kCell, cell_entries, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kMaterial, tables.materials, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kTexture, tables.textures, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kSampler, tables.samplers, 1));
+  sections.push_back(CreateBinaryStream(SectionType::kString, tables.strings, 1, ComponentFormat::kUint8));
+  LayoutSections(options.section_alignment, 0, &sections);
+  const auto binary_filename = GetOutputFilename(basename, "bin");
+  MeasureStage("write", metrics, [&]() { OutputContainerToFile(options.section_alignment, sections, GetOutputFilePath(output_directory, binary_filename.c_str()).c_str()); });
+  output_files->push_back(binary_filename);
+}
+// writes output files of a scene already imported and post-processed, returns material settings
+// texture paths are relative to input_directory
+// when container is not null, the container is output there instead and no file is written (textures are left as they are)
+auto ConvertScene(const aiScene& input_scene, const bool is_gltf, const char* const basename, const char* const input_directory, const char* const output_directory, const Options& options, ConversionMetrics* metrics, std::vector<std::string>* output_files, std::vector<uint8_t>* container = nullptr) {
+  const auto static_batch_scene = options.merge_static_meshes ? MeasureStage("static batch", metrics, [&]() { return CreateStaticBatchScene(input_scene, options.static_batch_max_vertices); }) : BorrowingScene{nullptr, {}};
+  const auto& scene = static_batch_scene ? *static_batch_scene : input_scene;
+  std::vector<uint32_t> material_index_remap;
+  auto material_settings = MeasureStage("material", metrics, [&]() { return CreateJsonMaterialList(options.thread_num, scene.mNumMaterials, scene.mMaterials, is_gltf, &material_index_remap); });
+  std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set;
+  if (container != nullptr) {
+    OutputSceneContainer(scene, material_index_remap, material_settings, options, nullptr, container, &per_draw_call_model_index_set, metrics);
+    CountMeshMetrics(per_draw_call_model_index_set, metrics);
+    metrics->bytes_written = container->size();
+    return material_settings;
+  }
+  std::filesystem::create_directories(output_directory);
+  // before containers, as compressed texture paths are written to material tables
+  if (options.compress_textures) {
+    MeasureStage("texture", metrics, [&]() { CompressTextures(scene, input_directory, output_directory, options, &material_settings["textures"], output_files); });
+  } else {
+    MeasureStage("texture packing", metrics, [&]() { WritePackedTextures(scene, input_directory, output_directory, options.thread_num, material_settings["textures"], output_files); });
+  }
+  if (options.spatial_cell_size > 0.0f) {
+    OutputSpatialCells(scene, material_index_remap, material_settings, options, basename, output_directory, metrics, output_files);
+  } else {
+    const auto binary_filename = GetOutputFilename(basename, "bin");
+    const auto sections = OutputSceneContainer(scene, material_index_remap, material_settings, options, GetOutputFilePath(output_directory, binary_filename.c_str()).c_str(), nullptr, &per_draw_call_model_index_set, metrics);
+    PushContainerFilenames(binary_filename.c_str(), sections, output_files);
+    if (options.output_json) {
+      WriteContainerJson(per_draw_call_model_index_set, sections, material_settings, options, binary_filename.c_str(), output_directory, metrics, output_files);
+    }
+    CountMeshMetrics(per_draw_call_model_index_set, metrics);
+  }
+  metrics->bytes_written = GetOutputSizeInBytes(output_directory, *output_files);
+  return material_settings;
+}
+auto IsGltfExtension(const std::filesystem::path& extension) {
+  return extension == ".gltf" || extension == ".glb";
+}
+enum class ConvertResult : uint8_t {
+  kFailed,
+  kConverted,
+  kCacheHit,
+};
+auto ConvertModel(const char* const input_filepath, const char* const output_dir_root, const Options& options, Assimp::Importer* importer) {
+  const auto basename_str = GetFilenameStem(input_filepath);
+  const auto basename = basename_str.c_str();
+  const auto output_directory = MergeStrings(output_dir_root, '/', basename);
+  if (!IsValidSectionAlignment(options.section_alignment)) {
+    logerror("section alignment must be a power of two >= {}. {}", kMinSectionAlignment, options.section_alignment);
+    return ConvertResult::kFailed;
+  }
+  uint32_t post_process_steps = 0;
+  if (!GetPostProcessSteps(options, &post_process_steps)) {
+    return ConvertResult::kFailed;
+  }
+  const auto use_cache = !options.cache_dir.empty();
+  uint64_t cache_key = 0;
+  if (use_cache) {
+    if (!ComputeCacheKey(input_filepath, post_process_steps, options, &cache_key)) {
+      logerror("failed to read {}", input_filepath);
+      return ConvertResult::kFailed;
+    }
+    if (RestoreFromCache(options.cache_dir.c_str(), cache_key, output_directory.c_str())) {
+      loginfo("cache hit {} {:016x}", input_filepath, cache_key);
+      return ConvertResult::kCacheHit;
+    }
+    loginfo("cache miss {} {:016x}", input_filepath, cache_key);
+  }
+  ConversionMetrics metrics;
+  const auto extension = std::filesystem::path(input_filepath).extension();
+  const auto is_gltf = IsGltfExtension(extension);
+  const auto direct_scene = IsDirectGltfImportApplicable(options, post_process_steps, is_gltf) ? ImportGltfScene(input_filepath, post_process_steps, &metrics) : nullptr;
+  const auto scene = direct_scene ? direct_scene.get() : ImportScene(input_filepath, post_process_steps, importer, &metrics);
+  if (!IsConvertibleScene(scene)) {
+    LogImportError(input_filepath, direct_scene != nullptr, *importer);
+    if (!direct_scene) { importer->FreeScene(); }
+    return ConvertResult::kFailed;
+  }
+  if (!IsWithinElementRange(*scene, options)) {
+    if (!direct_scene) { importer->FreeScene(); }
+    return ConvertResult::kFailed;
+  }
+  std::vector<std::string> output_files;
+  const auto input_directory = std::filesystem::path(input_filepath).parent_path().string();
+  const auto material_settings = ConvertScene(*scene, is_gltf, basename, input_directory.c_str(), output_directory.c_str(), options, &metrics, &output_files);
+  if (use_cache) {
+    const auto dependencies = CollectCacheDependencies(input_filepath, material_settings["textures"]);
+    StoreToCache(options.cache_dir.c_str(), cache_key, dependencies, output_directory.c_str(), output_files);
+  }
+  metrics.peak_rss_in_bytes = GetPeakRssInBytes();
+  LogMetrics(input_filepath, metrics);
+  if (!options.metrics_dir.empty()) {
+    std::filesystem::create_directories(options.metrics_dir);
+    WriteOutJson(CreateTraceJson(input_filepath, metrics), GetOutputFilePath(options.metrics_dir.c_str(), GetOutputFilename(basename, "trace.json").c_str()).c_str());
+  }
+  if (!direct_scene) { importer->FreeScene(); }
+  return ConvertResult::kConverted;
+}
+// import is done by import_gltf_scene(post_process_steps, metrics) if applicable and successful, otherwise by import_scene(post_process_steps, importer, metrics)
+template <typename G, typename F>
+auto ConvertModelToMemory(const char* const name, const char* const input_directory, const bool is_gltf, const Options& options, G&& import_gltf_scene, F&& import_scene) {
+  if (!IsValidSectionAlignment(options.section_alignment)) {
+    logerror("section alignment must be a power of two >= {}. {}", kMinSectionAlignment, options.section_alignment);
+    return ConversionResult{};
+  }
+  uint32_t post_process_steps = 0;
+  if (!GetPostProcessSteps(options, &post_process_steps)) {
+    return ConversionResult{};
+  }
+  ConversionMetrics metrics;
+  Assimp::Importer importer;
+  const auto direct_scene = IsDirectGltfImportApplicable(options, post_process_steps, is_gltf) ? import_gltf_scene(post_process_steps, &metrics) : nullptr;
+  const auto scene = direct_scene ? direct_scene.get() : import_scene(post_process_steps, &importer, &metrics);
+  if (!IsConvertibleScene(scene)) {
+    LogImportError(name, direct_scene != nullptr, importer);
+    return ConversionResult{};
+  }
+  if (!IsWithinElementRange(*scene, options)) {
+    return ConversionResult{};
+  }
+  std::vector<uint8_t> container;
+  const auto material_settings = ConvertScene(*scene, is_gltf, name, input_directory, "", options, &metrics, nullptr, &container);
+  metrics.peak_rss_in_bytes = GetPeakRssInBytes();
+  LogMetrics(name, metrics);
+  return ConversionResult(std::move(container), material_settings.dump());
+}
+auto MatchWildcard(const char* pattern, const char* str) -> bool {
+  if (*pattern == '\0') { return *str == '\0'; }
+  if (*pattern == '*') {
+    return MatchWildcard(pattern + 1, str) || (*str != '\0' && MatchWildcard(pattern, str + 1));
   }
-  logerror("invalid value for min filter {}", min_filter);
-  return "linear";
+  if (*str == '\0') { return false; }
+  if (*pattern != '?' && *pattern != *str) { return false; }
+  return MatchWildcard(pattern + 1, str + 1);
 }
-std::string GetMipFilter(const uint32_t min_filter) {
-  switch (min_filter) {
-    case SamplerFilter_UNSET:
-      return "linear";
-    case SamplerMinFilter_Nearest:
-      return "linear";
-    case SamplerMinFilter_Linear:
-      return "linear";
-    case SamplerMinFilter_Nearest_Mipmap_Nearest:
-      return "point";
-    case SamplerMinFilter_Linear_Mipmap_Nearest:
-      return "point";
-    case SamplerMinFilter_Nearest_Mipmap_Linear:
-      return "linear";
-    case SamplerMinFilter_Linear_Mipmap_Linear:
-      return "linear";
+auto GetEstimatedSceneMemoryInBytes(const std::filesystem::path& input_filepath) {
+  // rough estimate of peak memory while converting a scene, from sizes of the file and its .bin buffer (gltf)
+  const uint64_t kMemoryPerInputByte = 8;
+  std::error_code error_code;
+  uint64_t input_size = std::filesystem::file_size(input_filepath, error_code);
+  if (error_code) { return uint64_t{0}; }
+  auto buffer_filepath = input_filepath;
+  buffer_filepath.replace_extension(".bin");
+  if (const auto buffer_size = std::filesystem::file_size(buffer_filepath, error_code); !error_code) {
+    input_size += buffer_size;
   }
-  logerror("invalid value for mip filter {}", min_filter);
-  return "linear";
+  return input_size * kMemoryPerInputByte;
 }
-auto CreateTextureJson(const std::vector<Texture>& textures) {
-  auto json = nlohmann::json::array();
-  for (const auto& t : textures) {
-    nlohmann::json j;
-    switch (t.texture_type) {
-      case aiTextureType_UNKNOWN: // occulusion-metallic-roughness
-        j["type"] = "occulusion-metallic-roughness";
-        break;
-      case aiTextureType_BASE_COLOR:
-        j["type"] = "albedo";
-        break;
-      case aiTextureType_NORMALS:
-        j["type"] = "normal";
-        break;
-      case aiTextureType_EMISSIVE:
-        j["type"] = "emissive";
-        break;
+class MemoryBudget {
+ public:
+  explicit MemoryBudget(const uint64_t budget_in_bytes) : budget_in_bytes_(budget_in_bytes) {}
+  void Acquire(const uint64_t size_in_bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // a scene larger than the whole budget is still converted, alone.
+    while (budget_in_bytes_ != 0 && in_use_in_bytes_ != 0 && in_use_in_bytes_ + size_in_bytes > budget_in_bytes_) {
+      condition_.wait(lock);
     }
-    j["path"] = t.path;
-    json.emplace_back(std::move(j));
+    in_use_in_bytes_ += size_in_bytes;
+  }
+  void Release(const uint64_t size_in_bytes) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      in_use_in_bytes_ -= size_in_bytes;
+    }
+    condition_.notify_all();
+  }
+ private:
+  const uint64_t budget_in_bytes_;
+  uint64_t in_use_in_bytes_{0};
+  std::mutex mutex_;
+  std::condition_variable condition_;
+};
+struct BatchJob {
+  std::string input_filepath;
+  uint64_t estimated_memory_in_bytes{0};
+  double elapsed_ms{0.0};
+  ConvertResult result{ConvertResult::kFailed};
+};
+struct BatchContext {
+  std::vector<BatchJob> jobs;
+  std::atomic<uint32_t> next_job_index{0};
+  MemoryBudget* memory_budget{nullptr};
+  const char* output_dir{nullptr};
+  const Options* options{nullptr};
+};
+void ProcessBatchJobs(BatchContext* context) {
+  // importer is reused by all jobs on this worker
+  Assimp::Importer importer;
+  while (true) {
+    const auto job_index = context->next_job_index.fetch_add(1);
+    if (job_index >= context->jobs.size()) { break; }
+    auto& job = context->jobs[job_index];
+    context->memory_budget->Acquire(job.estimated_memory_in_bytes);
+    const auto start = std::chrono::steady_clock::now();
+    job.result = ConvertModel(job.input_filepath.c_str(), context->output_dir, *context->options, &importer);
+    job.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    context->memory_budget->Release(job.estimated_memory_in_bytes);
   }
-  return json;
 }
-auto CreateSamplerJson(const std::vector<Sampler>& samplers) {
-  auto json = nlohmann::json::array();
-  for (const auto& s : samplers) {
-    auto mapmode = nlohmann::json::array();
-    for (uint32_t i = 0; i < Sampler::kMapModeNum; i++) {
-      if (!IsValidMapMode(s.mapmode[i])) { continue; }
-      mapmode.emplace_back(GetMapMode(s.mapmode[i]));
+auto GetConvertResultName(const ConvertResult result) {
+  switch (result) {
+    case ConvertResult::kFailed:
+      return "FAILED";
+    case ConvertResult::kConverted:
+      return "ok";
+    case ConvertResult::kCacheHit:
+      return "cached";
+  }
+  return "";
+}
+void LogBatchSummary(const std::vector<BatchJob>& jobs, const double elapsed_ms) {
+  double total_ms = 0.0;
+  uint32_t failed_num = 0, cache_hit_num = 0;
+  for (const auto& job : jobs) {
+    loginfo("{:>10.1f}ms {:<6} {}", job.elapsed_ms, GetConvertResultName(job.result), job.input_filepath);
+    total_ms += job.elapsed_ms;
+    if (job.result == ConvertResult::kFailed) { failed_num++; }
+    if (job.result == ConvertResult::kCacheHit) { cache_hit_num++; }
+  }
+  loginfo("batch: {} files, {} failed, {} cache hits, wall {:.1f}s, sum of per-file {:.1f}s", jobs.size(), failed_num, cache_hit_num, elapsed_ms / 1000.0, total_ms / 1000.0);
+  for (const auto& job : jobs) {
+    if (job.result == ConvertResult::kFailed) {
+      logerror("failed: {}", job.input_filepath);
     }
-    nlohmann::json j;
-    j["mapmode"] = std::move(mapmode);
-    j["mag_filter"] = GetMagFilter(s.mag_filter);
-    j["min_filter"] = GetMinFilter(s.min_filter);
-    j["mip_filter"] = GetMipFilter(s.min_filter);
-    json.emplace_back(std::move(j));
   }
-  return json;
 }
-auto CreateJsonMaterialList(const uint32_t material_num, const aiMaterial * const * const materials, const bool is_gltf) {
-  auto json = nlohmann::json::array();
-  std::vector<Texture> textures;
-  std::vector<Sampler> samplers;
+auto CreateBenchmarkMesh(const uint32_t grid_size, const uint32_t material_index) {
+  const auto stride = grid_size + 1;
+  auto mesh = new aiMesh;
+  mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+  mesh->mMaterialIndex = material_index;
+  mesh->mNumVertices = stride * stride;
+  mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+  mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+  mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+  mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+  mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+  mesh->mNumUVComponents[0] = 2;
+  for (uint32_t y = 0; y < stride; y++) {
+    for (uint32_t x = 0; x < stride; x++) {
+      const auto index = y * stride + x;
+      const auto u = static_cast<float>(x) / static_cast<float>(grid_size);
+      const auto v = static_cast<float>(y) / static_cast<float>(grid_size);
+      // slightly bumpy to keep lod and overdraw optimization busy
+      mesh->mVertices[index] = aiVector3D(u, 0.05f * std::sin(u * 20.0f) * std::cos(v * 20.0f), v);
+      mesh->mNormals[index] = aiVector3D(0.0f, 1.0f, 0.0f);
+      mesh->mTangents[index] = aiVector3D(1.0f, 0.0f, 0.0f);
+      mesh->mBitangents[index] = aiVector3D(0.0f, 0.0f, 1.0f);
+      mesh->mTextureCoords[0][index] = aiVector3D(u, v, 0.0f);
+    }
+  }
+  mesh->mNumFaces = grid_size * grid_size * 2;
+  mesh->mFaces = new aiFace[mesh->mNumFaces];
+  for (uint32_t i = 0; i < grid_size * grid_size; i++) {
+    const auto v = (i / grid_size) * stride + i % grid_size;
+    const uint32_t quad[2][3] = {{v, v + stride, v + 1}, {v + 1, v + stride, v + stride + 1}};
+    for (uint32_t j = 0; j < 2; j++) {
+      auto& face = mesh->mFaces[i * 2 + j];
+      face.mNumIndices = 3;
+      face.mIndices = new unsigned int[3]{quad[j][0], quad[j][1], quad[j][2]};
+    }
+  }
+  return mesh;
+}
+auto CreateBenchmarkMaterial(const uint32_t material_index) {
+  auto material = new aiMaterial;
+  const aiString name(fmt::format("material{}", material_index));
+  material->AddProperty(&name, AI_MATKEY_NAME);
+  const aiColor4D base_color(static_cast<float>(material_index % 8) / 8.0f, 0.5f, 0.5f, 1.0f);
+  material->AddProperty(&base_color, 1, AI_MATKEY_BASE_COLOR);
+  return material;
+}
+auto CreateBenchmarkScene(const BenchmarkScene& desc) {
+  auto scene = std::make_unique<aiScene>();
+  const auto material_num = std::max(desc.material_num, 1U);
+  scene->mNumMaterials = material_num;
+  scene->mMaterials = new aiMaterial*[material_num];
   for (uint32_t i = 0; i < material_num; i++) {
-    const auto& material = *(materials[i]);
-    nlohmann::json material_json;
-    if (const auto shading_mode = GetShadingMode(material); shading_mode != aiShadingMode_PBR_BRDF) {
-      logwarn("only pbr/brdf is loaded so far. {}", shading_mode);
-      continue;
+    scene->mMaterials[i] = CreateBenchmarkMaterial(i);
+  }
+  scene->mNumMeshes = desc.mesh_num;
+  scene->mMeshes = new aiMesh*[desc.mesh_num];
+  for (uint32_t i = 0; i < desc.mesh_num; i++) {
+    scene->mMeshes[i] = CreateBenchmarkMesh(desc.grid_size, i % material_num);
+  }
+  // one node per instance, laid out on a plane
+  scene->mRootNode = new aiNode("root");
+  const auto node_num = desc.mesh_num * desc.instance_num;
+  scene->mRootNode->mNumChildren = node_num;
+  scene->mRootNode->mChildren = new aiNode*[node_num];
+  const auto row_len = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(node_num))));
+  for (uint32_t i = 0; i < node_num; i++) {
+    auto node = new aiNode(fmt::format("node{}", i));
+    node->mParent = scene->mRootNode;
+    aiMatrix4x4::Translation(aiVector3D(static_cast<float>(i % row_len), 0.0f, static_cast<float>(i / row_len)), node->mTransformation);
+    node->mNumMeshes = 1;
+    node->mMeshes = new unsigned int[1]{i % desc.mesh_num};
+    scene->mRootNode->mChildren[i] = node;
+  }
+  return scene;
+}
+void MergeBenchmarkResult(const BenchmarkScene& desc, const std::string& stage, const double elapsed_ms, const ConversionMetrics& metrics, std::vector<BenchmarkResult>* results) {
+  auto result = std::find_if(results->begin(), results->end(), [&](const BenchmarkResult& r) { return r.scene_name == desc.name && r.stage == stage; });
+  if (result == results->end()) {
+    results->push_back(BenchmarkResult{.scene_name = desc.name, .stage = stage, .elapsed_ms = elapsed_ms});
+    result = results->end() - 1;
+  }
+  result->elapsed_ms = std::min(result->elapsed_ms, elapsed_ms);
+  result->vertex_num = metrics.vertex_num;
+  result->bytes_written = metrics.bytes_written;
+  if (result->elapsed_ms <= 0.0) { return; }
+  const auto seconds = result->elapsed_ms / 1000.0;
+  result->vertices_per_second = static_cast<double>(result->vertex_num) / seconds;
+  result->megabytes_per_second = static_cast<double>(result->bytes_written) / (1024.0 * 1024.0) / seconds;
+}
+} // namespace anonymous
+bool OutputToDirectory(const char* const input_filepath, const char* const output_dir_root, const Options& options) {
+  Assimp::Importer importer;
+  return ConvertModel(input_filepath, output_dir_root, options, &importer) != ConvertResult::kFailed;
+}
+ConversionResult ConvertToMemory(const char* const input_filepath, const Options& options) {
+  const std::filesystem::path path(input_filepath);
+  const auto input_directory = path.parent_path().string();
+  return ConvertModelToMemory(input_filepath, input_directory.c_str(), IsGltfExtension(path.extension()), options, [&](const uint32_t post_process_steps, ConversionMetrics* metrics) {
+    return ImportGltfScene(input_filepath, post_process_steps, metrics);
+  }, [&](const uint32_t post_process_steps, Assimp::Importer* importer, ConversionMetrics* metrics) {
+    return ImportScene(input_filepath, post_process_steps, importer, metrics);
+  });
+}
+ConversionResult ConvertToMemory(const void* const data, const std::size_t size_in_bytes, const char* const format_hint, const Options& options) {
+  const auto is_gltf = IsGltfExtension(std::filesystem::path(std::string(".") + format_hint));
+  return ConvertModelToMemory("memory", "", is_gltf, options, [&](const uint32_t post_process_steps, ConversionMetrics* metrics) {
+    return ImportGltfSceneFromMemory(data, size_in_bytes, post_process_steps, metrics);
+  }, [&](const uint32_t post_process_steps, Assimp::Importer* importer, ConversionMetrics* metrics) {
+    return ImportSceneFromMemory(data, size_in_bytes, format_hint, post_process_steps, importer, metrics);
+  });
+}
+std::vector<std::string> ListInputFiles(const char* const list_file_or_glob) {
+  namespace fs = std::filesystem;
+  std::vector<std::string> filepaths;
+  const fs::path path(list_file_or_glob);
+  if (fs::is_directory(path)) {
+    Assimp::Importer importer;
+    for (const auto& entry : fs::recursive_directory_iterator(path)) {
+      if (!entry.is_regular_file()) { continue; }
+      const auto extension = entry.path().extension().string();
+      if (extension.empty() || !importer.IsExtensionSupported(extension.c_str())) { continue; }
+      filepaths.push_back(entry.path().generic_string());
     }
-    // assimp/code/AssetLib/glTF2/glTF2Asset.h Material
-    // assimp/code/AssetLib/glTF2/glTF2Importer.cpp ImportMaterial
-    {
-      material_json["albedo"]["texture"] = GetTexture(material, aiTextureType_BASE_COLOR, &textures, &samplers);
-      material_json["albedo"]["factor"]  = GetMaterialVal(material, AI_MATKEY_BASE_COLOR, {1.0f, 1.0f, 1.0f, 1.0f});
-    }
-    // https://github.com/sbtron/glTF/blob/30de0b365d1566b1bbd8b9c140f9e995d3203226/specification/2.0/README.md#pbrmetallicroughnessmetallicroughnesstexture
-    if (is_gltf) {
-      auto texture = GetTexture(material, aiTextureType_UNKNOWN /*=AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE*/, &textures, &samplers);
-      material_json["occlusion"]["texture"] = texture;
-      material_json["occlusion"]["texture"]["channel"] = 0; // for R channel
-      material_json["occlusion"]["strength"] = GetMaterialVal(material, AI_MATKEY_GLTF_TEXTURE_STRENGTH(aiTextureType_LIGHTMAP, 0), 1.0f);
-      material_json["metallic"]["texture"] = texture;
-      material_json["metallic"]["texture"]["channel"] = 1; // for G channel
-      material_json["metallic"]["factor"] = GetMaterialVal(material, AI_MATKEY_METALLIC_FACTOR, 1.0f);
-      material_json["roughness"]["texture"] = texture;
-      material_json["roughness"]["texture"]["channel"]  = 2; // for B channel
-      material_json["roughness"]["factor"] = GetMaterialVal(material, AI_MATKEY_ROUGHNESS_FACTOR, 1.0f);
-    } else {
-      logerror("none-gltf model load not implemented.");
-      // post-process to combine occlusion(R),metallic(G),roughness(B) textues to single texture not implemented yet.
-      // consider using libvips.
-      assert(false);
+  } else if (strpbrk(list_file_or_glob, "*?") != nullptr) {
+    const auto directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+    const auto pattern = path.filename().string();
+    std::error_code error_code;
+    for (const auto& entry : fs::directory_iterator(directory, error_code)) {
+      if (!entry.is_regular_file()) { continue; }
+      if (!MatchWildcard(pattern.c_str(), entry.path().filename().string().c_str())) { continue; }
+      filepaths.push_back(entry.path().generic_string());
     }
-    {
-      material_json["normal"]["texture"] = GetTexture(material, aiTextureType_NORMALS, &textures, &samplers);
-      material_json["normal"]["scale"]   = GetMaterialVal(material, AI_MATKEY_GLTF_TEXTURE_SCALE(aiTextureType_NORMALS, 0), 1.0f);
+  } else {
+    std::ifstream list_file(path);
+    if (!list_file) {
+      logerror("failed to open list file {}", list_file_or_glob);
+      return filepaths;
     }
-    {
-      material_json["emissive"]["texture"] = GetTexture(material, aiTextureType_EMISSIVE, &textures, &samplers);
-      material_json["emissive"]["factor"]  = GetMaterialVal(material, AI_MATKEY_COLOR_EMISSIVE, {1.0f, 1.0f, 1.0f, 1.0f});
+    std::string line;
+    while (std::getline(list_file, line)) {
+      if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+      if (line.empty() || line[0] == '#') { continue; }
+      filepaths.push_back(line);
     }
-    material_json["double_sided"] = GetMaterialVal(material, AI_MATKEY_TWOSIDED, false);
-    material_json["alpha_mode"] = GetMaterialStrVal(material, AI_MATKEY_GLTF_ALPHAMODE, "OPAQUE");
-    material_json["alpha_cutoff"] = GetMaterialVal(material, AI_MATKEY_GLTF_ALPHACUTOFF, 0.2f);
-    json.emplace_back(std::move(material_json));
   }
-  nlohmann::json ret;
-  ret["materials"] = std::move(json);
-  ret["textures"] = CreateTextureJson(textures);
-  ret["samplers"] = CreateSamplerJson(samplers);
-  return ret;
+  std::sort(filepaths.begin(), filepaths.end());
+  return filepaths;
 }
-} // namespace anonymous
-void OutputToDirectory(const char* const input_filepath, const char* const output_dir_root) {
-  using namespace modelconv;
-  const auto basename_str = GetFilenameStem(input_filepath);
-  const auto basename = basename_str.c_str();
-  Assimp::Importer importer;
-  const auto scene = importer.ReadFile(input_filepath,
-                                       aiProcess_MakeLeftHanded 
-                                       | aiProcess_FlipWindingOrder 
-                                       | aiProcess_Triangulate 
-                                       | aiProcess_CalcTangentSpace
-                                       | aiProcess_JoinIdenticalVertices
-                                       | aiProcess_ValidateDataStructure
-                                       | aiProcess_FixInfacingNormals
-                                       | aiProcess_SortByPType
-                                       | aiProcess_GenSmoothNormals
-                                       | aiProcess_FindInvalidData
-                                       | aiProcess_GenUVCoords
-                                       | aiProcess_TransformUVCoords
-                                       | aiProcess_FindInstances
-                                       | aiProcess_Debone
-                                       | aiProcess_RemoveRedundantMaterials);
-  // consider using meshoptimizer (https://github.com/zeux/meshoptimizer) for mesh optimizations.
-  if (scene == nullptr || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) != 0 || !scene->HasMeshes() || scene->mRootNode == nullptr) {
-    logerror("failed to load scene. {}", input_filepath);
-    return;
+uint32_t BatchOutputToDirectory(const std::vector<std::string>& input_filepaths, const char* const output_dir_root, const Options& options, const BatchOptions& batch_options) {
+  std::filesystem::create_directories(output_dir_root);
+  MemoryBudget memory_budget(batch_options.memory_budget_in_bytes);
+  BatchContext context;
+  context.memory_budget = &memory_budget;
+  context.output_dir = output_dir_root;
+  context.jobs.reserve(input_filepaths.size());
+  // files with the same stem would write to the same output directory concurrently, only the first one is converted
+  std::unordered_map<std::string, std::string> output_names;
+  std::vector<BatchJob> rejected_jobs;
+  for (const auto& input_filepath : input_filepaths) {
+    const auto [it, inserted] = output_names.try_emplace(GetFilenameStem(input_filepath.c_str()), input_filepath);
+    if (!inserted) {
+      logerror("{} is skipped, {} is written to the same output directory", input_filepath, it->second);
+      rejected_jobs.push_back(BatchJob{.input_filepath = input_filepath, .result = ConvertResult::kFailed});
+      continue;
+    }
+    context.jobs.push_back(BatchJob{
+        .input_filepath = input_filepath,
+        .estimated_memory_in_bytes = GetEstimatedSceneMemoryInBytes(input_filepath),
+      });
   }
-  std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set(scene->mNumMeshes);
-  const auto transform_matrix_list = GetTransformMatrixList(scene->mRootNode, per_draw_call_model_index_set.data());
-  const auto [transform_index_list_offset, transform_index_list] = FlattenTransformIndexLists(per_draw_call_model_index_set);
-  const auto mesh_buffers = GatherMeshData(scene->mNumMeshes, scene->mMeshes, &per_draw_call_model_index_set);
-  const auto binary_filename = GetOutputFilename(basename, "bin");
-  const auto output_directory = MergeStrings(output_dir_root, '/', basename);
-  std::filesystem::create_directory(output_directory);
-  OutputBinariesToFile(transform_matrix_list, transform_index_list_offset, transform_index_list, mesh_buffers, GetOutputFilePath(output_directory.c_str(), binary_filename.c_str()).c_str());
-  nlohmann::json json;
-  json["meshes"] = CreateMeshJson(per_draw_call_model_index_set);
-  json["binary_info"] = CreateJsonBinaryEntityList(transform_matrix_list, transform_index_list_offset, transform_index_list, mesh_buffers);
-  json["binary_filename"] = binary_filename;
-  json["material_settings"] = CreateJsonMaterialList(scene->mNumMaterials, scene->mMaterials, true);
-  const auto json_filepath = GetOutputFilePath(output_directory.c_str(), GetOutputFilename(basename, "json").c_str());
-  WriteOutJson(json, json_filepath.c_str());
+  // largest first for better load balance
+  std::stable_sort(context.jobs.begin(), context.jobs.end(), [](const BatchJob& a, const BatchJob& b) { return a.estimated_memory_in_bytes > b.estimated_memory_in_bytes; });
+  const auto thread_num = std::min(GetThreadNum(batch_options.thread_num), std::max(GetUint32(context.jobs.size()), 1U));
+  auto scene_options = options;
+  if (thread_num > 1 && scene_options.thread_num == 0) {
+    // files are already processed in parallel
+    scene_options.thread_num = 1;
+  }
+  context.options = &scene_options;
+  loginfo("batch: {} files with {} threads", context.jobs.size(), thread_num);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  threads.reserve(thread_num);
+  for (uint32_t i = 0; i < thread_num; i++) {
+    threads.emplace_back(ProcessBatchJobs, &context);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  context.jobs.insert(context.jobs.end(), rejected_jobs.begin(), rejected_jobs.end());
+  std::sort(context.jobs.begin(), context.jobs.end(), [](const BatchJob& a, const BatchJob& b) { return a.input_filepath < b.input_filepath; });
+  LogBatchSummary(context.jobs, elapsed_ms);
+  return GetUint32(std::count_if(context.jobs.begin(), context.jobs.end(), [](const BatchJob& job) { return job.result == ConvertResult::kFailed; }));
+}
+std::vector<BenchmarkScene> GetDefaultBenchmarkScenes() {
+  std::vector<BenchmarkScene> scenes;
+  scenes.push_back(BenchmarkScene{.name = "base"});
+  scenes.push_back(BenchmarkScene{.name = "many_meshes", .mesh_num = 1024, .grid_size = 15});
+  scenes.push_back(BenchmarkScene{.name = "large_meshes", .mesh_num = 4, .grid_size = 511});
+  scenes.push_back(BenchmarkScene{.name = "many_instances", .instance_num = 256});
+  scenes.push_back(BenchmarkScene{.name = "many_materials", .mesh_num = 256, .grid_size = 15, .material_num = 256});
+  return scenes;
+}
+std::vector<BenchmarkResult> RunBenchmark(const std::vector<BenchmarkScene>& scenes, const char* const output_dir, const Options& options, const uint32_t iteration_num) {
+  std::vector<BenchmarkResult> results;
+  for (const auto& desc : scenes) {
+    const auto scene = CreateBenchmarkScene(desc);
+    const auto output_directory = MergeStrings(output_dir, '/', desc.name.c_str());
+    for (const auto streaming_write : {false, true}) {
+      auto scene_options = options;
+      scene_options.streaming_write = streaming_write;
+      scene_options.output_json = false;
+      const std::string prefix = streaming_write ? "streaming " : "";
+      for (uint32_t i = 0; i < iteration_num; i++) {
+        ConversionMetrics metrics;
+        std::vector<std::string> output_files;
+        MeasureStage("total", &metrics, [&]() { ConvertScene(*scene, false, desc.name.c_str(), "", output_directory.c_str(), scene_options, &metrics, &output_files); });
+        for (const auto& stage : metrics.stages) {
+          MergeBenchmarkResult(desc, prefix + stage.name, stage.elapsed_ms, metrics, &results);
+        }
+      }
+    }
+    loginfo("benchmark {} done", desc.name);
+  }
+  return results;
 }
 } // namespace modelconv
 #include "doctest/doctest.h"
@@ -704,22 +4334,7 @@ TEST_CASE("load model") {
   const auto basename_str = GetFilenameStem(filename);
   const auto basename = basename_str.c_str();
   Assimp::Importer importer;
-  const auto scene = importer.ReadFile(filename,
-                                       aiProcess_MakeLeftHanded 
-                                       | aiProcess_FlipWindingOrder 
-                                       | aiProcess_Triangulate 
-                                       | aiProcess_CalcTangentSpace
-                                       | aiProcess_JoinIdenticalVertices
-                                       | aiProcess_ValidateDataStructure
-                                       | aiProcess_FixInfacingNormals
-                                       | aiProcess_SortByPType
-                                       | aiProcess_GenSmoothNormals
-                                       | aiProcess_FindInvalidData
-                                       | aiProcess_GenUVCoords
-                                       | aiProcess_TransformUVCoords
-                                       | aiProcess_FindInstances
-                                       | aiProcess_Debone
-                                       | aiProcess_RemoveRedundantMaterials);
+  const auto scene = importer.ReadFile(filename, GetPresetPostProcessSteps(PostProcessPreset::kDefault));
   CHECK_NE(scene, nullptr);
   CHECK_EQ((scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE), 0);
   CHECK_UNARY(scene->HasMeshes());
@@ -727,19 +4342,890 @@ TEST_CASE("load model") {
   std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set(scene->mNumMeshes);
   const auto transform_matrix_list = GetTransformMatrixList(scene->mRootNode, per_draw_call_model_index_set.data());
   const auto [transform_index_list_offset, transform_index_list] = FlattenTransformIndexLists(per_draw_call_model_index_set);
-  const auto mesh_buffers = GatherMeshData(scene->mNumMeshes, scene->mMeshes, &per_draw_call_model_index_set);
+  auto mesh_buffers = GatherMeshData(0, scene->mNumMeshes, scene->mMeshes, &per_draw_call_model_index_set);
+  OptimizeMeshes(0, per_draw_call_model_index_set, &mesh_buffers);
+  BuildLods({0.5f, 0.25f}, 0.01f, &mesh_buffers, &per_draw_call_model_index_set);
+  const auto meshlet_buffers = BuildMeshlets(64, 124, mesh_buffers, &per_draw_call_model_index_set);
+  std::vector<uint8_t> narrowed_index_buffer;
+  const auto index_stream = CreateIndexStream(true, false, mesh_buffers.index_buffer, &narrowed_index_buffer, &per_draw_call_model_index_set);
+  const auto vertex_streams = CreateSeparateVertexStreams(mesh_buffers, nullptr);
+  std::vector<uint32_t> material_index_remap;
+  const auto material_settings = CreateJsonMaterialList(0, scene->mNumMaterials, scene->mMaterials, true, &material_index_remap);
+  AssignMaterialIndices(scene->mNumMeshes, scene->mMeshes, material_index_remap, &per_draw_call_model_index_set);
+  ContainerTables container_tables;
+  const auto sections = CreateSectionList(kMinSectionAlignment, 0, false, transform_matrix_list, transform_index_list_offset, transform_index_list, index_stream, vertex_streams, meshlet_buffers, material_settings, &per_draw_call_model_index_set, &container_tables);
   const auto binary_filename = GetOutputFilename(basename, "bin");
   const auto output_directory = MergeStrings(directory, '/', basename);
   std::filesystem::create_directory(output_directory);
-  OutputBinariesToFile(transform_matrix_list, transform_index_list_offset, transform_index_list, mesh_buffers, GetOutputFilePath(output_directory.c_str(), binary_filename.c_str()).c_str());
+  OutputContainerToFile(kMinSectionAlignment, sections, GetOutputFilePath(output_directory.c_str(), binary_filename.c_str()).c_str());
   nlohmann::json json;
   json["meshes"] = CreateMeshJson(per_draw_call_model_index_set);
-  json["binary_info"] = CreateJsonBinaryEntityList(transform_matrix_list, transform_index_list_offset, transform_index_list, mesh_buffers);
+  json["binary_info"] = CreateJsonBinaryEntityList(kMinSectionAlignment, sections);
   json["binary_filename"] = binary_filename;
-  json["material_settings"] = CreateJsonMaterialList(scene->mNumMaterials, scene->mMaterials, true);
+  json["material_settings"] = material_settings;
   const auto json_filepath = GetOutputFilePath(output_directory.c_str(), GetOutputFilename(basename, "json").c_str());
   WriteOutJson(json, json_filepath.c_str());
 }
 TEST_CASE("interface test") {
   modelconv::OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output");
 }
+namespace {
+template <typename T = char>
+auto ReadTestFile(const std::string& filepath) {
+  std::ifstream file(filepath, std::ios::in | std::ios::binary);
+  return std::vector<T>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+auto CreateTestGridMesh(const uint32_t grid_size, modelconv::MeshBuffers* mesh_buffers) {
+  // grid of quads with triangles in scattered order
+  for (uint32_t y = 0; y <= grid_size; y++) {
+    for (uint32_t x = 0; x <= grid_size; x++) {
+      mesh_buffers->vertex_buffer_position.insert(mesh_buffers->vertex_buffer_position.end(), {static_cast<float>(x), static_cast<float>(y), 0.0f});
+      mesh_buffers->vertex_buffer_normal.insert(mesh_buffers->vertex_buffer_normal.end(), {0.0f, 0.0f, 1.0f});
+      mesh_buffers->vertex_buffer_tangent.insert(mesh_buffers->vertex_buffer_tangent.end(), {1.0f, 0.0f, 0.0f});
+      mesh_buffers->vertex_buffer_texcoord.insert(mesh_buffers->vertex_buffer_texcoord.end(), {static_cast<float>(x), static_cast<float>(y)});
+      mesh_buffers->vertex_buffer_tangent_sign.push_back((x % 2 == 0) ? 1 : -1);
+    }
+  }
+  const uint32_t kStride = grid_size + 1;
+  const uint32_t kQuadNum = grid_size * grid_size;
+  for (uint32_t i = 0; i < kQuadNum; i++) {
+    const auto quad = (i * 193) % kQuadNum;
+    const auto v = (quad / grid_size) * kStride + quad % grid_size;
+    mesh_buffers->index_buffer.insert(mesh_buffers->index_buffer.end(), {v, v + kStride, v + 1, v + 1, v + kStride, v + kStride + 1});
+  }
+  std::vector<modelconv::PerDrawCallModelIndexSet> per_draw_call_model_index_set(1);
+  per_draw_call_model_index_set[0].index_buffer_len = modelconv::GetUint32(mesh_buffers->index_buffer.size());
+  per_draw_call_model_index_set[0].vertex_num = kStride * kStride;
+  return per_draw_call_model_index_set;
+}
+} // namespace anonymous
+TEST_CASE("mesh optimization") {
+  using namespace modelconv;
+  const uint32_t kGridSize = 32;
+  const uint32_t kStride = kGridSize + 1;
+  const uint32_t kQuadNum = kGridSize * kGridSize;
+  MeshBuffers mesh_buffers;
+  const auto per_draw_call_model_index_set = CreateTestGridMesh(kGridSize, &mesh_buffers);
+  const auto stats_before = AnalyzeVertexCache(per_draw_call_model_index_set, mesh_buffers);
+  OptimizeMeshes(0, per_draw_call_model_index_set, &mesh_buffers);
+  const auto stats_after = AnalyzeVertexCache(per_draw_call_model_index_set, mesh_buffers);
+  CHECK_LT(stats_after.acmr, stats_before.acmr);
+  CHECK_LT(stats_after.atvr, stats_before.atvr);
+  CHECK_EQ(mesh_buffers.index_buffer.size(), kQuadNum * 6);
+  // vertex attributes must follow remapped positions
+  for (uint32_t i = 0; i < kStride * kStride; i++) {
+    CHECK_EQ(mesh_buffers.vertex_buffer_position[i * 3],     mesh_buffers.vertex_buffer_texcoord[i * 2]);
+    CHECK_EQ(mesh_buffers.vertex_buffer_position[i * 3 + 1], mesh_buffers.vertex_buffer_texcoord[i * 2 + 1]);
+  }
+  // unreferenced vertex 0 does not stay in the vertex range
+  MeshBuffers unreferenced_buffers;
+  unreferenced_buffers.index_buffer = {1, 2, 3};
+  unreferenced_buffers.vertex_buffer_position = {9.0f, 9.0f, 9.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+  PerDrawCallModelIndexSet unreferenced_mesh;
+  unreferenced_mesh.index_buffer_len = 3;
+  unreferenced_mesh.vertex_num = 4;
+  OptimizeMeshes(0, {unreferenced_mesh}, &unreferenced_buffers);
+  CHECK_EQ(std::count(unreferenced_buffers.vertex_buffer_position.begin(), unreferenced_buffers.vertex_buffer_position.end(), 9.0f), 0);
+  CHECK_UNARY(std::equal(unreferenced_buffers.vertex_buffer_position.begin(), unreferenced_buffers.vertex_buffer_position.begin() + 3, unreferenced_buffers.vertex_buffer_position.begin() + 9));
+}
+TEST_CASE("meshlet") {
+  using namespace modelconv;
+  const uint32_t kMaxVertices = 64;
+  const uint32_t kMaxTriangles = 124;
+  MeshBuffers mesh_buffers;
+  auto per_draw_call_model_index_set = CreateTestGridMesh(16, &mesh_buffers);
+  OptimizeMeshes(0, per_draw_call_model_index_set, &mesh_buffers);
+  const auto meshlet_buffers = BuildMeshlets(kMaxVertices, kMaxTriangles, mesh_buffers, &per_draw_call_model_index_set);
+  const auto& mesh = per_draw_call_model_index_set[0];
+  CHECK_EQ(mesh.meshlet_offset, 0);
+  CHECK_GT(mesh.meshlet_num, 1);
+  CHECK_EQ(meshlet_buffers.meshlet.size(), mesh.meshlet_num * kMeshletComponentNum);
+  CHECK_EQ(meshlet_buffers.meshlet_bounds.size(), mesh.meshlet_num * kMeshletBoundsComponentNum);
+  CHECK_EQ(meshlet_buffers.meshlet_triangles.size() % 4, 0);
+  uint32_t triangle_num = 0;
+  for (uint32_t i = 0; i < mesh.meshlet_num; i++) {
+    const auto vertex_offset   = meshlet_buffers.meshlet[i * kMeshletComponentNum];
+    const auto triangle_offset = meshlet_buffers.meshlet[i * kMeshletComponentNum + 1];
+    const auto vertex_count    = meshlet_buffers.meshlet[i * kMeshletComponentNum + 2];
+    const auto triangle_count  = meshlet_buffers.meshlet[i * kMeshletComponentNum + 3];
+    CHECK_LE(vertex_count, kMaxVertices);
+    CHECK_LE(triangle_count, kMaxTriangles);
+    CHECK_EQ(triangle_offset % 4, 0);
+    for (uint32_t j = 0; j < triangle_count * 3; j++) {
+      const auto local_index = meshlet_buffers.meshlet_triangles[triangle_offset + j];
+      CHECK_LT(local_index, vertex_count);
+      CHECK_LT(meshlet_buffers.meshlet_vertices[vertex_offset + local_index], mesh.vertex_num);
+    }
+    CHECK_GT(meshlet_buffers.meshlet_bounds[i * kMeshletBoundsComponentNum + 3], 0.0f);
+    triangle_num += triangle_count;
+  }
+  CHECK_EQ(triangle_num, mesh.index_buffer_len / 3);
+}
+TEST_CASE("lod") {
+  using namespace modelconv;
+  MeshBuffers mesh_buffers;
+  auto per_draw_call_model_index_set = CreateTestGridMesh(16, &mesh_buffers);
+  OptimizeMeshes(0, per_draw_call_model_index_set, &mesh_buffers);
+  const auto lod0_index_num = mesh_buffers.index_buffer.size();
+  BuildLods({0.5f, 0.25f}, 0.01f, &mesh_buffers, &per_draw_call_model_index_set);
+  const auto& mesh = per_draw_call_model_index_set[0];
+  CHECK_EQ(mesh.index_buffer_offset, 0);
+  CHECK_EQ(mesh.index_buffer_len, lod0_index_num);
+  CHECK_EQ(mesh.lods.size(), 2);
+  auto prev_index_num = mesh.index_buffer_len;
+  for (const auto& lod : mesh.lods) {
+    CHECK_LT(lod.index_buffer_len, prev_index_num);
+    CHECK_EQ(lod.index_buffer_len % 3, 0);
+    CHECK_LE(lod.index_buffer_offset + lod.index_buffer_len, mesh_buffers.index_buffer.size());
+    CHECK_GE(lod.error, 0.0f);
+    for (uint32_t i = 0; i < lod.index_buffer_len; i++) {
+      CHECK_LT(mesh_buffers.index_buffer[lod.index_buffer_offset + i], mesh.vertex_num);
+    }
+    prev_index_num = lod.index_buffer_len;
+  }
+}
+TEST_CASE("vertex quantization") {
+  using namespace modelconv;
+  MeshBuffers mesh_buffers;
+  auto per_draw_call_model_index_set = CreateTestGridMesh(4, &mesh_buffers);
+  const auto vertex_num = per_draw_call_model_index_set[0].vertex_num;
+  {
+    // octahedral encoding of axis directions
+    const float up[] = {0.0f, 0.0f, 1.0f};
+    CHECK_EQ(EncodeOctahedral(up), std::make_pair(0.0f, 0.0f));
+    const float down[] = {0.0f, 0.0f, -1.0f};
+    CHECK_EQ(EncodeOctahedral(down), std::make_pair(1.0f, 1.0f));
+    const float right[] = {1.0f, 0.0f, 0.0f};
+    CHECK_EQ(EncodeOctahedral(right), std::make_pair(1.0f, 0.0f));
+  }
+  const auto quantized = QuantizeMeshBuffers(true, true, mesh_buffers, &per_draw_call_model_index_set);
+  const auto& mesh = per_draw_call_model_index_set[0];
+  CHECK_EQ(quantized.vertex_buffer_position.size(), vertex_num * kQuantizedPositionComponentNum);
+  CHECK_EQ(quantized.vertex_buffer_normal.size(), vertex_num * 2);
+  CHECK_EQ(quantized.vertex_buffer_tangent.size(), vertex_num * 2);
+  CHECK_EQ(quantized.vertex_buffer_texcoord.size(), vertex_num * 2);
+  CHECK_EQ(mesh.position_offset[0], 0.0f);
+  CHECK_EQ(mesh.position_scale[0], 4.0f);
+  CHECK_EQ(mesh.position_scale[2], 1.0f); // flat extent
+  CHECK_EQ(mesh.texcoord_scale[1], 4.0f);
+  for (uint32_t i = 0; i < vertex_num; i++) {
+    const auto dequantized_x = static_cast<float>(quantized.vertex_buffer_position[i * kQuantizedPositionComponentNum]) / 65535.0f * mesh.position_scale[0] + mesh.position_offset[0];
+    CHECK_LT(std::abs(dequantized_x - mesh_buffers.vertex_buffer_position[i * 3]), 1e-3f);
+    CHECK_EQ(quantized.vertex_buffer_normal[i * 2], 0);
+    CHECK_EQ(quantized.vertex_buffer_normal[i * 2 + 1], 0);
+    CHECK_EQ(quantized.vertex_buffer_tangent[i * 2], 32767);
+    CHECK_EQ((quantized.vertex_buffer_tangent[i * 2 + 1] & 1) != 0, mesh_buffers.vertex_buffer_tangent_sign[i] < 0);
+  }
+  const auto half_quantized = QuantizeMeshBuffers(false, false, mesh_buffers, &per_draw_call_model_index_set);
+  CHECK_UNARY(half_quantized.vertex_buffer_position.empty());
+  CHECK_EQ(half_quantized.vertex_buffer_texcoord[2], meshopt_quantizeHalf(mesh_buffers.vertex_buffer_texcoord[2]));
+}
+TEST_CASE("interleaved vertex layout") {
+  using namespace modelconv;
+  MeshBuffers mesh_buffers;
+  const auto per_draw_call_model_index_set = CreateTestGridMesh(4, &mesh_buffers);
+  const auto vertex_num = per_draw_call_model_index_set[0].vertex_num;
+  {
+    std::vector<uint8_t> interleaved_buffer;
+    const auto streams = CreateVertexStreams(VertexLayout::kSeparate, CreateSeparateVertexStreams(mesh_buffers, nullptr), &interleaved_buffer);
+    CHECK_EQ(streams.size(), 4);
+    CHECK_UNARY(interleaved_buffer.empty());
+  }
+  {
+    std::vector<uint8_t> interleaved_buffer;
+    const auto streams = CreateVertexStreams(VertexLayout::kPositionAndInterleaved, CreateSeparateVertexStreams(mesh_buffers, nullptr), &interleaved_buffer);
+    CHECK_EQ(streams.size(), 2);
+    CHECK_EQ(streams[0].stride_in_bytes, 12);
+    CHECK_EQ(streams[1].stride_in_bytes, 32);
+    CHECK_EQ(streams[1].size_in_bytes, vertex_num * 32);
+    CHECK_EQ(streams[1].attributes.size(), 3);
+    CHECK_EQ(streams[1].attributes[2].offset_in_bytes, 24);
+  }
+  {
+    std::vector<uint8_t> interleaved_buffer;
+    const auto streams = CreateVertexStreams(VertexLayout::kInterleaved, CreateSeparateVertexStreams(mesh_buffers, nullptr), &interleaved_buffer);
+    CHECK_EQ(streams.size(), 1);
+    const auto& stream = streams[0];
+    CHECK_EQ(stream.stride_in_bytes, 44);
+    CHECK_EQ(stream.size_in_bytes, vertex_num * 44);
+    for (uint32_t i = 0; i < vertex_num; i++) {
+      float position[3], texcoord[2];
+      memcpy(position, interleaved_buffer.data() + i * stream.stride_in_bytes, sizeof(position));
+      memcpy(texcoord, interleaved_buffer.data() + i * stream.stride_in_bytes + stream.attributes[3].offset_in_bytes, sizeof(texcoord));
+      CHECK_EQ(position[0], mesh_buffers.vertex_buffer_position[i * 3]);
+      CHECK_EQ(position[2], mesh_buffers.vertex_buffer_position[i * 3 + 2]);
+      CHECK_EQ(texcoord[1], mesh_buffers.vertex_buffer_texcoord[i * 2 + 1]);
+    }
+  }
+  {
+    MeshBuffers quantize_source = mesh_buffers;
+    auto index_set = per_draw_call_model_index_set;
+    const auto quantized = QuantizeMeshBuffers(true, false, quantize_source, &index_set);
+    std::vector<uint8_t> interleaved_buffer;
+    const auto streams = CreateVertexStreams(VertexLayout::kInterleaved, CreateSeparateVertexStreams(quantize_source, &quantized), &interleaved_buffer);
+    CHECK_EQ(streams[0].stride_in_bytes, 8 + 4 + 4 + 4);
+  }
+}
+TEST_CASE("index buffer narrowing") {
+  using namespace modelconv;
+  MeshBuffers mesh_buffers;
+  auto per_draw_call_model_index_set = CreateTestGridMesh(4, &mesh_buffers);
+  // append a mesh too large for uint16 indices
+  per_draw_call_model_index_set.emplace_back();
+  per_draw_call_model_index_set.back().index_buffer_offset = GetUint32(mesh_buffers.index_buffer.size());
+  per_draw_call_model_index_set.back().index_buffer_len = 3;
+  per_draw_call_model_index_set.back().vertex_num = kMaxUint16IndexVertexNum + 1;
+  mesh_buffers.index_buffer.insert(mesh_buffers.index_buffer.end(), {0, kMaxUint16IndexVertexNum, 1});
+  // lod with odd index count to test alignment of the following range
+  per_draw_call_model_index_set[0].lods.push_back(LodIndexRange{.index_buffer_offset = 0, .index_buffer_len = 3});
+  std::vector<uint8_t> narrowed_index_buffer;
+  const auto index_stream = CreateIndexStream(true, false, mesh_buffers.index_buffer, &narrowed_index_buffer, &per_draw_call_model_index_set);
+  CHECK_EQ(index_stream.attributes[0].format, ComponentFormat::kPerMesh);
+  CHECK_EQ(narrowed_index_buffer.size() % kIndexBufferAlignment, 0);
+  const auto& small_mesh = per_draw_call_model_index_set[0];
+  const auto& large_mesh = per_draw_call_model_index_set[1];
+  CHECK_EQ(small_mesh.index_stride_in_bytes, 2);
+  CHECK_EQ(large_mesh.index_stride_in_bytes, 4);
+  CHECK_EQ(small_mesh.index_buffer_offset_in_bytes, 0);
+  CHECK_EQ(small_mesh.lods[0].index_buffer_offset_in_bytes % kIndexBufferAlignment, 0);
+  CHECK_EQ(large_mesh.index_buffer_offset_in_bytes % kIndexBufferAlignment, 0);
+  for (uint32_t i = 0; i < small_mesh.index_buffer_len; i++) {
+    uint16_t index = 0;
+    memcpy(&index, narrowed_index_buffer.data() + small_mesh.index_buffer_offset_in_bytes + i * sizeof(uint16_t), sizeof(uint16_t));
+    CHECK_EQ(index, mesh_buffers.index_buffer[small_mesh.index_buffer_offset + i]);
+  }
+  uint32_t large_index = 0;
+  memcpy(&large_index, narrowed_index_buffer.data() + large_mesh.index_buffer_offset_in_bytes + sizeof(uint32_t), sizeof(uint32_t));
+  CHECK_EQ(large_index, kMaxUint16IndexVertexNum);
+}
+TEST_CASE("batch conversion") {
+  using namespace modelconv;
+  CHECK_UNARY(MatchWildcard("*.gltf", "BoomBox.gltf"));
+  CHECK_UNARY(MatchWildcard("Boom?ox*", "BoomBox.gltf"));
+  CHECK_UNARY_FALSE(MatchWildcard("*.gltf", "BoomBox.glb"));
+  CHECK_UNARY_FALSE(MatchWildcard("a*b", "a"));
+  CHECK_EQ(BatchOutputToDirectory({"glTF/BoomBoxWithAxes.gltf", "glTF/not_existing_file.gltf"}, "output/batch", {}, {.thread_num = 2}), 1);
+  // same output directory, the second one fails without being converted
+  CHECK_EQ(BatchOutputToDirectory({"glTF/BoomBoxWithAxes.gltf", "other/BoomBoxWithAxes.fbx"}, "output/batch", {}, {.thread_num = 2}), 1);
+}
+TEST_CASE("conversion cache") {
+  using namespace modelconv;
+  CHECK_EQ(DecodeUri("Boom%20Box.bin"), "Boom Box.bin");
+  CHECK_EQ(DecodeUri("BoomBox.bin"), "BoomBox.bin");
+  CHECK_EQ(HashBytes("a", 1, kFnvOffsetBasis), 0xaf63dc4c8601ec8cULL);
+  Options options;
+  options.cache_dir = "output/cache";
+  std::filesystem::remove_all(options.cache_dir);
+  Assimp::Importer importer;
+  CHECK_EQ(ConvertModel("glTF/BoomBoxWithAxes.gltf", "output", options, &importer), ConvertResult::kConverted);
+  CHECK_EQ(ConvertModel("glTF/BoomBoxWithAxes.gltf", "output", options, &importer), ConvertResult::kCacheHit);
+  options.optimize_mesh = !options.optimize_mesh;
+  CHECK_EQ(ConvertModel("glTF/BoomBoxWithAxes.gltf", "output", options, &importer), ConvertResult::kConverted);
+}
+TEST_CASE("intra-scene parallelism") {
+  using namespace modelconv;
+  std::vector<uint32_t> values(1000, 0);
+  ParallelFor(4, GetUint32(values.size()), [&](const uint32_t i) { values[i] += i; });
+  for (uint32_t i = 0; i < values.size(); i++) {
+    CHECK_EQ(values[i], i);
+  }
+  Options options;
+  options.output_json = true;
+  options.thread_num = 1;
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/serial", options));
+  options.thread_num = 4;
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/parallel", options));
+  for (const auto* const filename : {"BoomBoxWithAxes.bin", "BoomBoxWithAxes.json"}) {
+    const auto serial = ReadTestFile(fmt::format("output/serial/BoomBoxWithAxes/{}", filename));
+    CHECK_FALSE(serial.empty());
+    CHECK_EQ(serial, ReadTestFile(fmt::format("output/parallel/BoomBoxWithAxes/{}", filename)));
+  }
+}
+TEST_CASE("binary container") {
+  using namespace modelconv;
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output"));
+  const auto buffer = ReadTestFile("output/BoomBoxWithAxes/BoomBoxWithAxes.bin");
+  const auto data = buffer.data();
+  const auto header = GetContainerHeader(data);
+  CHECK_NE(header, nullptr);
+  CHECK_EQ(header->file_size_in_bytes, buffer.size());
+  const auto sections = GetSectionTable(data);
+  for (uint32_t i = 0; i < header->section_num; i++) {
+    CHECK_EQ(sections[i].offset_in_bytes % kMinSectionAlignment, 0);
+    CHECK_LE(sections[i].offset_in_bytes + sections[i].size_in_bytes, header->file_size_in_bytes);
+  }
+  const auto mesh_section = FindSection(data, SectionType::kMesh);
+  CHECK_NE(mesh_section, nullptr);
+  CHECK_EQ(mesh_section->stride_in_bytes, sizeof(MeshEntry));
+  CHECK_EQ(mesh_section->size_in_bytes, sizeof(MeshEntry));
+  const auto& mesh = GetSectionData<MeshEntry>(data, *mesh_section)[0];
+  CHECK_GT(mesh.vertex_num, 0);
+  CHECK_EQ(mesh.lod_num, 1);
+  const auto index_section = FindSection(data, SectionType::kIndex);
+  CHECK_EQ(index_section->format, ComponentFormat::kUint16);
+  CHECK_LE(mesh.index_buffer_offset_in_bytes + mesh.index_buffer_len * mesh.index_stride_in_bytes, index_section->size_in_bytes);
+  const auto texture_section = FindSection(data, SectionType::kTexture);
+  const auto string_section = FindSection(data, SectionType::kString);
+  CHECK_GT(texture_section->size_in_bytes, 0);
+  const auto& texture = GetSectionData<TextureEntry>(data, *texture_section)[0];
+  const std::string path(GetSectionData<char>(data, *string_section) + texture.path_offset, texture.path_len);
+  CHECK_FALSE(path.empty());
+}
+TEST_CASE("section alignment") {
+  using namespace modelconv;
+  CHECK_UNARY(IsValidSectionAlignment(256));
+  CHECK_FALSE(IsValidSectionAlignment(8));
+  CHECK_FALSE(IsValidSectionAlignment(300));
+  Options options;
+  options.section_alignment = 4096;
+  options.group_streams_per_mesh = true;
+  options.lod_target_ratios = {0.5f};
+  options.narrow_index_buffer = false;
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/aligned", options));
+  const auto buffer = ReadTestFile("output/aligned/BoomBoxWithAxes/BoomBoxWithAxes.bin");
+  const auto data = buffer.data();
+  const auto header = GetContainerHeader(data);
+  CHECK_NE(header, nullptr);
+  CHECK_EQ(header->section_alignment, 4096);
+  const auto sections = GetSectionTable(data);
+  for (uint32_t i = 1; i < header->section_num; i++) {
+    const auto& section = sections[i];
+    const auto same_mesh = section.mesh_index != kInvalidIndex && sections[i - 1].mesh_index == section.mesh_index;
+    CHECK_EQ(section.offset_in_bytes % (same_mesh ? kMinSectionAlignment : 4096), 0);
+    CHECK_EQ(sections[i - 1].offset_in_bytes + sections[i - 1].size_in_bytes + section.padding_in_bytes, section.offset_in_bytes);
+  }
+  const auto& mesh = GetSectionData<MeshEntry>(data, *FindSection(data, SectionType::kMesh))[0];
+  CHECK_EQ(mesh.vertex_buffer_index_offset, 0);
+  CHECK_EQ(mesh.index_buffer_offset_in_bytes, 0);
+  CHECK_EQ(mesh.data_offset_in_bytes % 4096, 0);
+  const auto& last_lod = GetSectionData<LodEntry>(data, *FindSection(data, SectionType::kLod))[mesh.lod_offset + mesh.lod_num - 1];
+  // all streams of the mesh including lods are within a single range
+  for (uint32_t i = 0; i < header->section_num; i++) {
+    if (sections[i].mesh_index != 0) { continue; }
+    CHECK_GE(sections[i].offset_in_bytes, mesh.data_offset_in_bytes);
+    CHECK_LE(sections[i].offset_in_bytes + sections[i].size_in_bytes, mesh.data_offset_in_bytes + mesh.data_size_in_bytes);
+    if (sections[i].type == SectionType::kIndex) {
+      CHECK_LE(last_lod.index_buffer_offset_in_bytes + last_lod.index_buffer_len * mesh.index_stride_in_bytes, sections[i].size_in_bytes);
+    }
+  }
+}
+TEST_CASE("streaming write") {
+  using namespace modelconv;
+  Options options;
+  options.output_json = true;
+  options.quantize_vertex = true;
+  options.quantize_position = true;
+  options.vertex_layout = VertexLayout::kPositionAndInterleaved;
+  for (const auto group_streams_per_mesh : {false, true}) {
+    options.group_streams_per_mesh = group_streams_per_mesh;
+    options.streaming_write = false;
+    CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/gathered", options));
+    options.streaming_write = true;
+    CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/streamed", options));
+    for (const auto* const filename : {"BoomBoxWithAxes.bin", "BoomBoxWithAxes.json"}) {
+      const auto gathered = ReadTestFile(fmt::format("output/gathered/BoomBoxWithAxes/{}", filename));
+      CHECK_FALSE(gathered.empty());
+      CHECK_EQ(gathered, ReadTestFile(fmt::format("output/streamed/BoomBoxWithAxes/{}", filename)));
+    }
+  }
+}
+TEST_CASE("post-process presets") {
+  using namespace modelconv;
+  const auto fast = GetPresetPostProcessSteps(PostProcessPreset::kFast);
+  const auto thorough = GetPresetPostProcessSteps(PostProcessPreset::kThorough);
+  CHECK_EQ(fast & aiProcess_JoinIdenticalVertices, 0);
+  CHECK_EQ(fast & ~thorough, 0);
+  for (const auto& step : kPostProcessStepList) {
+    CHECK_NE(FindPostProcessStep(step.name), nullptr);
+  }
+  Options options;
+  options.post_process_preset = PostProcessPreset::kFast;
+  options.enabled_post_process_steps = {"JoinIdenticalVertices"};
+  options.disabled_post_process_steps = {"TransformUVCoords"};
+  uint32_t post_process_steps = 0;
+  CHECK_UNARY(GetPostProcessSteps(options, &post_process_steps));
+  CHECK_EQ(post_process_steps, (fast | aiProcess_JoinIdenticalVertices) & ~aiProcess_TransformUVCoords);
+  options.enabled_post_process_steps = {"NoSuchStep"};
+  CHECK_FALSE(GetPostProcessSteps(options, &post_process_steps));
+  CHECK_FALSE(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/fast", options));
+  for (const auto preset : {PostProcessPreset::kFast, PostProcessPreset::kThorough}) {
+    Options preset_options;
+    preset_options.post_process_preset = preset;
+    CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/preset", preset_options));
+  }
+  ConversionMetrics metrics;
+  Assimp::Importer importer;
+  const auto scene = ImportScene("glTF/BoomBoxWithAxes.gltf", fast, &importer, &metrics);
+  CHECK_NE(scene, nullptr);
+  CHECK_EQ(metrics.stages.front().name, "import");
+  CHECK_EQ(metrics.stages.size(), 1 + std::bitset<32>(fast).count());
+  // one by one gives the same scene as applying all steps at once
+  Assimp::Importer stepwise_importer, combined_importer;
+  const auto stepwise_scene = ImportScene("glTF/BoomBoxWithAxes.gltf", thorough, &stepwise_importer, &metrics);
+  const auto combined_scene = combined_importer.ReadFile("glTF/BoomBoxWithAxes.gltf", thorough);
+  REQUIRE_NE(stepwise_scene, nullptr);
+  REQUIRE_NE(combined_scene, nullptr);
+  REQUIRE_EQ(stepwise_scene->mNumMeshes, combined_scene->mNumMeshes);
+  for (uint32_t i = 0; i < stepwise_scene->mNumMeshes; i++) {
+    CHECK_EQ(stepwise_scene->mMeshes[i]->mNumFaces, combined_scene->mMeshes[i]->mNumFaces);
+    CHECK_EQ(stepwise_scene->mMeshes[i]->mNumVertices, combined_scene->mMeshes[i]->mNumVertices);
+  }
+}
+TEST_CASE("conversion metrics") {
+  using namespace modelconv;
+  Options options;
+  options.metrics_dir = "output/metrics";
+  std::filesystem::remove_all(options.metrics_dir);
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/metrics_output", options));
+  std::ifstream file("output/metrics/BoomBoxWithAxes.trace.json");
+  const auto json = nlohmann::json::parse(file);
+  std::vector<std::string> names;
+  for (const auto& event : json["traceEvents"]) {
+    names.push_back(event["name"].get<std::string>());
+    CHECK_GE(event["ts"].get<double>(), 0.0);
+  }
+  for (const auto* const name : {"import", "transform", "material", "gather", "write", "counters"}) {
+    CHECK_NE(std::find(names.begin(), names.end(), name), names.end());
+  }
+  const auto& counters = json["otherData"];
+  CHECK_GT(counters["vertex_num"].get<uint64_t>(), 0);
+  CHECK_GT(counters["triangle_num"].get<uint64_t>(), 0);
+  CHECK_EQ(counters["bytes_written"].get<uint64_t>(), std::filesystem::file_size("output/metrics_output/BoomBoxWithAxes/BoomBoxWithAxes.bin"));
+  CHECK_GT(counters["peak_rss_in_bytes"].get<uint64_t>(), 0);
+}
+TEST_CASE("benchmark") {
+  using namespace modelconv;
+  const std::vector<BenchmarkScene> scenes{BenchmarkScene{.name = "test", .mesh_num = 3, .grid_size = 8, .instance_num = 2, .material_num = 2}};
+  const auto scene = CreateBenchmarkScene(scenes[0]);
+  CHECK_EQ(scene->mRootNode->mNumChildren, 6);
+  CHECK_EQ(scene->mMeshes[2]->mMaterialIndex, 0);
+  CHECK_EQ(scene->mMeshes[0]->mNumFaces, 8 * 8 * 2);
+  const auto results = RunBenchmark(scenes, "output/benchmark", {}, 1);
+  for (const auto* const stage : {"gather", "write", "total", "streaming gather and write", "streaming total"}) {
+    const auto result = std::find_if(results.begin(), results.end(), [&](const BenchmarkResult& r) { return r.stage == stage; });
+    CHECK_NE(result, results.end());
+    if (result == results.end()) { continue; }
+    CHECK_EQ(result->vertex_num, 3 * 9 * 9);
+    CHECK_GT(result->bytes_written, 0);
+  }
+}
+TEST_CASE("texture compression") {
+  using namespace modelconv;
+  MipLevel image{.width = 3, .height = 2, .rgba = std::vector<uint8_t>(3 * 2 * 4, 255), .blocks = {}};
+  image.rgba[0] = 0;
+  const auto mips = CreateMipChain(std::move(image), TextureCompression::kBc7Srgb);
+  CHECK_EQ(mips.size(), 2);
+  CHECK_EQ(mips[1].width, 1);
+  CHECK_EQ(mips[1].height, 1);
+  CHECK_GT(mips[1].rgba[0], 128); // averaged in linear space
+  CHECK_LT(mips[1].rgba[0], 255);
+  CHECK_EQ(mips[1].rgba[1], 255);
+  Options options;
+  options.compress_textures = true;
+  options.output_json = true;
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/textures", options));
+  std::ifstream json_file("output/textures/BoomBoxWithAxes/BoomBoxWithAxes.json");
+  const auto json = nlohmann::json::parse(json_file);
+  uint32_t albedo_num = 0;
+  for (const auto& texture : json["material_settings"]["textures"]) {
+    if (texture["type"] != "albedo") { continue; }
+    albedo_num++;
+    const auto path = texture["path"].get<std::string>();
+    CHECK_UNARY(path.ends_with(".dds"));
+    CHECK_NE(texture["source_path"], texture["path"]);
+    std::ifstream dds_file("output/textures/BoomBoxWithAxes/" + path, std::ios::in | std::ios::binary);
+    DdsHeader header{};
+    dds_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    CHECK_UNARY(dds_file.good());
+    CHECK_EQ(memcmp(&header.magic, "DDS ", 4), 0);
+    CHECK_EQ(header.dxgi_format, 99);
+    CHECK_GT(header.mip_map_count, 1);
+  }
+  CHECK_GT(albedo_num, 0);
+}
+TEST_CASE("orm texture packing") {
+  using namespace modelconv;
+  std::filesystem::create_directories("output/orm");
+  const uint8_t occlusion[] = {10, 20, 30, 40}; // 2x2 grayscale
+  const uint8_t roughness[] = {50};             // 1x1 grayscale
+  CHECK_NE(stbi_write_png("output/orm/occlusion.png", 2, 2, 1, occlusion, 2), 0);
+  CHECK_NE(stbi_write_png("output/orm/roughness.png", 1, 1, 1, roughness, 1), 0);
+  nlohmann::json texture;
+  texture["sources"]["occlusion"] = "occlusion.png";
+  texture["sources"]["roughness"] = "roughness.png";
+  aiScene scene;
+  MipLevel image;
+  CHECK_UNARY(DecodeTexture(scene, "output/orm", texture, 2, &image));
+  CHECK_EQ(image.width, 2);
+  CHECK_EQ(image.height, 2);
+  for (uint32_t i = 0; i < 4; i++) {
+    CHECK_EQ(image.rgba[i * 4 + 0], occlusion[i]);
+    CHECK_EQ(image.rgba[i * 4 + 1], roughness[0]);
+    CHECK_EQ(image.rgba[i * 4 + 2], 0); // default metallic
+    CHECK_EQ(image.rgba[i * 4 + 3], 255);
+  }
+  Texture a{.texture_type = aiTextureType_UNKNOWN, .path = {}, .packed_paths = {"occlusion.png", "roughness.png", ""}};
+  TextureList textures;
+  CHECK_EQ(FindOrCreateTexture(Texture{a}, &textures), 0);
+  CHECK_EQ(FindOrCreateTexture(Texture{a}, &textures), 0);
+  a.packed_paths[2] = "metallic.png";
+  CHECK_EQ(FindOrCreateTexture(Texture{a}, &textures), 1);
+  const auto json = CreateTextureJson(textures.textures);
+  CHECK_EQ(json[0]["path"], "textures/occlusion_orm.png");
+  CHECK_EQ(json[1]["path"], "textures/occlusion_orm_1.png");
+  CHECK_EQ(json[1]["sources"]["metallic"], "metallic.png");
+  Options options;
+  options.output_json = true;
+  CHECK_UNARY(OutputToDirectory("donut2022.fbx", "output/fbx", options));
+  std::ifstream json_file("output/fbx/donut2022/donut2022.json");
+  const auto output_json = nlohmann::json::parse(json_file);
+  for (const auto& material : output_json["material_settings"]["materials"]) {
+    CHECK_UNARY(material.contains("metallic_roughness_occlusion"));
+    CHECK_UNARY_FALSE(material.contains("metallic"));
+  }
+}
+TEST_CASE("material deduplication") {
+  using namespace modelconv;
+  // benchmark materials repeat every 8 materials
+  const auto scene = CreateBenchmarkScene(BenchmarkScene{.name = "test", .mesh_num = 12, .grid_size = 1, .instance_num = 1, .material_num = 12});
+  std::vector<uint32_t> material_index_remap;
+  const auto material_settings = CreateJsonMaterialList(0, scene->mNumMaterials, scene->mMaterials, false, &material_index_remap);
+  CHECK_EQ(material_settings["materials"].size(), 8);
+  CHECK_EQ(material_settings["textures"].size(), 4);
+  CHECK_EQ(material_settings["samplers"].size(), 1);
+  CHECK_EQ(material_index_remap.size(), 12);
+  CHECK_EQ(material_index_remap[8], material_index_remap[0]);
+  CHECK_EQ(material_index_remap[11], material_index_remap[3]);
+  CHECK_NE(material_index_remap[1], material_index_remap[0]);
+  std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set(scene->mNumMeshes);
+  AssignMaterialIndices(scene->mNumMeshes, scene->mMeshes, material_index_remap, &per_draw_call_model_index_set);
+  CHECK_EQ(per_draw_call_model_index_set[9].material_index, 1);
+  const aiTextureMapMode wrap[] = {aiTextureMapMode_Wrap, aiTextureMapMode_Wrap, static_cast<aiTextureMapMode>(-1)};
+  const aiTextureMapMode wrap_unset[] = {aiTextureMapMode_Wrap, aiTextureMapMode_Wrap, static_cast<aiTextureMapMode>(-2)};
+  SamplerList samplers;
+  CHECK_EQ(FindOrCreateSampler(wrap, SamplerMagFilter_Linear, SamplerMinFilter_Linear, &samplers), 0);
+  CHECK_EQ(FindOrCreateSampler(wrap_unset, SamplerMagFilter_Linear, SamplerMinFilter_Linear, &samplers), 0);
+  CHECK_EQ(FindOrCreateSampler(wrap, SamplerMagFilter_Nearest, SamplerMinFilter_Linear, &samplers), 1);
+}
+TEST_CASE("static batch") {
+  using namespace modelconv;
+  // 6 meshes of 9 vertices in 2 materials, each drawn once
+  const auto scene = CreateBenchmarkScene(BenchmarkScene{.name = "test", .mesh_num = 6, .grid_size = 2, .instance_num = 1, .material_num = 2});
+  {
+    const auto batch_scene = CreateStaticBatchScene(*scene, 0xFFFF);
+    CHECK_EQ(batch_scene->mNumMeshes, 2);
+    CHECK_EQ(batch_scene->mMeshes[0]->mNumVertices, 27);
+    CHECK_EQ(batch_scene->mMeshes[0]->mNumFaces, 3 * 8);
+    CHECK_EQ(batch_scene->mMeshes[1]->mMaterialIndex, 1);
+    // mesh 2 is the second part of the first batch, translated by node 2
+    const auto& src = *scene->mMeshes[2];
+    const auto& dst = batch_scene->mMeshes[0]->mVertices[9];
+    CHECK_LT(std::abs(dst.x - (src.mVertices[0].x + scene->mRootNode->mChildren[2]->mTransformation.a4)), 1e-5f);
+    CHECK_LT(std::abs(dst.z - (src.mVertices[0].z + scene->mRootNode->mChildren[2]->mTransformation.c4)), 1e-5f);
+    CHECK_EQ(batch_scene->mMeshes[0]->mFaces[8].mIndices[0], src.mFaces[0].mIndices[0] + 9);
+    std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set(batch_scene->mNumMeshes);
+    const auto transform_matrix_list = GetTransformMatrixList(batch_scene->mRootNode, per_draw_call_model_index_set.data());
+    CHECK_EQ(transform_matrix_list.size(), 16);
+    CHECK_EQ(per_draw_call_model_index_set[1].transform_matrix_index_list.size(), 1);
+  }
+  {
+    // no mesh fits into a batch with another
+    const auto batch_scene = CreateStaticBatchScene(*scene, 10);
+    CHECK_EQ(batch_scene->mNumMeshes, 6);
+  }
+  {
+    const auto instanced_scene = CreateBenchmarkScene(BenchmarkScene{.name = "test", .mesh_num = 6, .grid_size = 2, .instance_num = 2, .material_num = 2});
+    const auto batch_scene = CreateStaticBatchScene(*instanced_scene, 0xFFFF);
+    CHECK_EQ(batch_scene->mNumMeshes, 6);
+    CHECK_EQ(batch_scene->mMeshes[0], instanced_scene->mMeshes[0]);
+    std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set(batch_scene->mNumMeshes);
+    GetTransformMatrixList(batch_scene->mRootNode, per_draw_call_model_index_set.data());
+    CHECK_EQ(per_draw_call_model_index_set[0].transform_matrix_index_list.size(), 2);
+  }
+  Options options;
+  options.merge_static_meshes = true;
+  options.output_json = true;
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/static_batch", options));
+}
+TEST_CASE("bounds and bvh") {
+  using namespace modelconv;
+  // 64 instances of 4 flat 1x1 meshes on an 8x8 grid
+  const auto scene = CreateBenchmarkScene(BenchmarkScene{.name = "test", .mesh_num = 4, .grid_size = 2, .instance_num = 16, .material_num = 1});
+  std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set(scene->mNumMeshes);
+  const auto transform_matrix_list = GetTransformMatrixList(scene->mRootNode, per_draw_call_model_index_set.data());
+  const auto [transform_index_list_offset, transform_index_list] = FlattenTransformIndexLists(per_draw_call_model_index_set);
+  ContainerTables tables;
+  CreateBoundsTables(2, scene->mNumMeshes, scene->mMeshes, transform_matrix_list, transform_index_list_offset, transform_index_list, &tables);
+  CHECK_EQ(tables.mesh_bounds.size(), 4);
+  CHECK_EQ(tables.mesh_bounds[0].aabb_min[0], 0.0f);
+  CHECK_EQ(tables.mesh_bounds[0].aabb_max[0], 1.0f);
+  CHECK_EQ(tables.mesh_bounds[0].sphere_center[0], 0.5f);
+  CHECK_GE(tables.mesh_bounds[0].sphere_radius, std::sqrt(0.5f));
+  CHECK_EQ(tables.instance_bounds.size(), 64);
+  for (const auto& instance : tables.instance_bounds) {
+    const auto translation = &transform_matrix_list[instance.transform_index * 16];
+    CHECK_EQ(instance.aabb_min[0], translation[3]);
+    CHECK_EQ(instance.aabb_max[2], translation[11] + 1.0f);
+  }
+  BuildInstanceBvh(&tables);
+  CHECK_EQ(tables.bvh_instances.size(), 64);
+  CHECK_GT(tables.bvh_nodes.size(), 1);
+  CHECK_EQ(tables.bvh_nodes[0].aabb_min[0], 0.0f);
+  CHECK_EQ(tables.bvh_nodes[0].aabb_max[0], 8.0f);
+  // every instance is in exactly one leaf and inside the leaf bounds
+  std::vector<uint32_t> leaf_count(tables.instance_bounds.size(), 0);
+  for (const auto& node : tables.bvh_nodes) {
+    if (node.instance_num == 0) {
+      CHECK_LT(node.offset, tables.bvh_nodes.size());
+      continue;
+    }
+    CHECK_LE(node.instance_num, kBvhMaxLeafInstanceNum);
+    for (uint32_t i = node.offset; i < node.offset + node.instance_num; i++) {
+      const auto& instance = tables.instance_bounds[tables.bvh_instances[i]];
+      leaf_count[tables.bvh_instances[i]]++;
+      for (uint32_t j = 0; j < 3; j++) {
+        CHECK_GE(instance.aabb_min[j], node.aabb_min[j]);
+        CHECK_LE(instance.aabb_max[j], node.aabb_max[j]);
+      }
+    }
+  }
+  CHECK_EQ(std::count(leaf_count.begin(), leaf_count.end(), 1), 64);
+  Options options;
+  options.build_bvh = true;
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/bvh", options));
+  const auto buffer = ReadTestFile("output/bvh/BoomBoxWithAxes/BoomBoxWithAxes.bin");
+  const auto mesh_bounds_section = FindSection(buffer.data(), SectionType::kMeshBounds);
+  CHECK_NE(mesh_bounds_section, nullptr);
+  CHECK_EQ(mesh_bounds_section->size_in_bytes, sizeof(MeshBoundsEntry));
+  CHECK_GT(FindSection(buffer.data(), SectionType::kBvhNode)->size_in_bytes, 0);
+}
+TEST_CASE("in-memory conversion") {
+  using namespace modelconv;
+  CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/memory"));
+  const auto buffer = ReadTestFile<uint8_t>("output/memory/BoomBoxWithAxes/BoomBoxWithAxes.bin");
+  auto result = ConvertToMemory("glTF/BoomBoxWithAxes.gltf");
+  CHECK_UNARY(static_cast<bool>(result));
+  CHECK_UNARY(std::equal(buffer.begin(), buffer.end(), result.GetContainer().begin(), result.GetContainer().end()));
+  CHECK_EQ(nlohmann::json::parse(result.GetMaterialSettingsJson())["materials"].size(), 1);
+  // views stay valid after move
+  const auto container_data = result.GetContainer().data();
+  const auto moved = std::move(result);
+  CHECK_EQ(moved.GetContainer().data(), container_data);
+  const auto meshes = moved.GetSectionData<MeshEntry>(SectionType::kMesh);
+  CHECK_EQ(meshes.size(), 1);
+  CHECK_EQ(moved.GetSectionData<float>(SectionType::kPosition).size(), meshes[0].vertex_num * 3);
+  CHECK_EQ(moved.GetSections().size(), GetContainerHeader(container_data)->section_num);
+  const auto fbx = ReadTestFile("donut2022.fbx");
+  const auto fbx_result = ConvertToMemory(fbx.data(), fbx.size(), "fbx");
+  CHECK_UNARY(static_cast<bool>(fbx_result));
+  CHECK_GT(fbx_result.GetSectionData<MeshEntry>(SectionType::kMesh).size(), 0);
+  const auto invalid_result = ConvertToMemory(fbx.data(), 16, "fbx");
+  CHECK_FALSE(static_cast<bool>(invalid_result));
+  CHECK_UNARY(invalid_result.GetSections().empty());
+}
+TEST_CASE("direct gltf import") {
+  using namespace modelconv;
+  const char* const filename = "glTF/BoomBoxWithAxes.gltf";
+  Options options;
+  options.post_process_preset = PostProcessPreset::kFast;
+  CHECK_UNARY(IsDirectGltfImportApplicable(options, kFastPostProcessSteps, true));
+  CHECK_UNARY_FALSE(IsDirectGltfImportApplicable(options, kFastPostProcessSteps, false));
+  CHECK_UNARY(IsDirectGltfImportApplicable(options, kDefaultPostProcessSteps, true));
+  CHECK_UNARY_FALSE(IsDirectGltfImportApplicable(options, kThoroughPostProcessSteps, true));
+  ConversionMetrics metrics;
+  const auto direct_scene = ImportGltfScene(filename, kFastPostProcessSteps, &metrics);
+  REQUIRE_NE(direct_scene, nullptr);
+  Assimp::Importer importer;
+  const auto scene = ImportScene(filename, kFastPostProcessSteps, &importer, &metrics);
+  REQUIRE_UNARY(IsConvertibleScene(scene));
+  REQUIRE_EQ(direct_scene->mNumMeshes, scene->mNumMeshes);
+  for (uint32_t i = 0; i < scene->mNumMeshes; i++) {
+    const auto& direct_mesh = *direct_scene->mMeshes[i];
+    const auto& mesh = *scene->mMeshes[i];
+    REQUIRE_EQ(direct_mesh.mNumVertices, mesh.mNumVertices);
+    REQUIRE_EQ(direct_mesh.mNumFaces, mesh.mNumFaces);
+    CHECK_EQ(direct_mesh.mMaterialIndex, mesh.mMaterialIndex);
+    uint32_t mismatch_num = 0;
+    for (uint32_t j = 0; j < mesh.mNumVertices; j++) {
+      if (direct_mesh.mVertices[j].z != mesh.mVertices[j].z || direct_mesh.mTextureCoords[0][j].y != mesh.mTextureCoords[0][j].y) { mismatch_num++; }
+      if (GetTangentSign(direct_mesh.mNormals[j], direct_mesh.mTangents[j], direct_mesh.mBitangents[j]) != GetTangentSign(mesh.mNormals[j], mesh.mTangents[j], mesh.mBitangents[j])) { mismatch_num++; }
+    }
+    for (uint32_t j = 0; j < mesh.mNumFaces; j++) {
+      if (!std::equal(direct_mesh.mFaces[j].mIndices, direct_mesh.mFaces[j].mIndices + 3, mesh.mFaces[j].mIndices)) { mismatch_num++; }
+    }
+    CHECK_EQ(mismatch_num, 0);
+  }
+  // vertex order differs with JoinIdenticalVertices, assimp joins with an epsilon instead of exact matches
+  const auto direct_default_scene = ImportGltfScene(filename, kDefaultPostProcessSteps, &metrics);
+  REQUIRE_NE(direct_default_scene, nullptr);
+  Assimp::Importer default_importer;
+  const auto default_scene = ImportScene(filename, kDefaultPostProcessSteps, &default_importer, &metrics);
+  REQUIRE_UNARY(IsConvertibleScene(default_scene));
+  REQUIRE_EQ(direct_default_scene->mNumMeshes, default_scene->mNumMeshes);
+  for (uint32_t i = 0; i < default_scene->mNumMeshes; i++) {
+    CHECK_EQ(direct_default_scene->mMeshes[i]->mNumFaces, default_scene->mMeshes[i]->mNumFaces);
+    CHECK_LE(default_scene->mMeshes[i]->mNumVertices, direct_default_scene->mMeshes[i]->mNumVertices);
+    CHECK_LE(direct_default_scene->mMeshes[i]->mNumVertices, direct_scene->mMeshes[i]->mNumVertices);
+  }
+  const auto direct = ConvertToMemory(filename, options);
+  options.direct_gltf_import = false;
+  CHECK_UNARY_FALSE(IsDirectGltfImportApplicable(options, kFastPostProcessSteps, true));
+  const auto assimp = ConvertToMemory(filename, options);
+  REQUIRE_UNARY(static_cast<bool>(direct));
+  REQUIRE_UNARY(static_cast<bool>(assimp));
+  CHECK_EQ(direct.GetMaterialSettingsJson(), assimp.GetMaterialSettingsJson());
+  for (const auto type : {SectionType::kIndex, SectionType::kPosition, SectionType::kTexcoord, SectionType::kMaterial, SectionType::kSampler}) {
+    CHECK_UNARY(std::ranges::equal(direct.GetSectionData<uint8_t>(type), assimp.GetSectionData<uint8_t>(type)));
+  }
+}
+TEST_CASE("chunked output") {
+  using namespace modelconv;
+  const auto reference = ConvertToMemory("glTF/BoomBoxWithAxes.gltf");
+  for (const auto group_streams_per_mesh : {false, true}) {
+    Options options;
+    options.group_streams_per_mesh = group_streams_per_mesh;
+    options.chunk_size_in_bytes = 32 * 1024;
+    std::filesystem::remove_all("output/chunk");
+    CHECK_UNARY(OutputToDirectory("glTF/BoomBoxWithAxes.gltf", "output/chunk", options));
+    std::vector<std::vector<char>> chunks;
+    for (uint32_t i = 0; ; i++) {
+      const auto chunk_filename = GetChunkFilename("output/chunk/BoomBoxWithAxes/BoomBoxWithAxes.bin", i);
+      if (!std::filesystem::exists(chunk_filename)) { break; }
+      chunks.push_back(ReadTestFile(chunk_filename));
+    }
+    const auto header = GetContainerHeader(chunks[0].data());
+    CHECK_NE(header, nullptr);
+    CHECK_GT(header->chunk_num, 1);
+    CHECK_EQ(header->chunk_num, chunks.size());
+    CHECK_EQ(header->file_size_in_bytes, chunks[0].size());
+    const auto sections = GetSectionTable(chunks[0].data());
+    std::vector<uint32_t> section_num_per_chunk(chunks.size(), 0);
+    for (uint32_t i = 0; i < header->section_num; i++) {
+      const auto& section = sections[i];
+      CHECK_LT(section.chunk_index, chunks.size());
+      CHECK_LE(section.offset_in_bytes + section.size_in_bytes, chunks[section.chunk_index].size());
+      section_num_per_chunk[section.chunk_index]++;
+      if (group_streams_per_mesh) { continue; }
+      // same data as a single file
+      const auto& reference_section = reference.GetSections()[i];
+      CHECK_EQ(section.type, reference_section.type);
+      CHECK_EQ(section.size_in_bytes, reference_section.size_in_bytes);
+      const auto data = GetSectionData<char>(chunks[section.chunk_index].data(), section);
+      CHECK_UNARY(std::equal(data, data + section.size_in_bytes, reference.GetSectionData<char>(reference_section).begin()));
+    }
+    for (uint32_t i = 0; i < chunks.size(); i++) {
+      // only a section (or a mesh) larger than a chunk exceeds the size
+      CHECK_UNARY(chunks[i].size() <= options.chunk_size_in_bytes || section_num_per_chunk[i] == 1 || group_streams_per_mesh);
+    }
+  }
+  const auto scene = CreateBenchmarkScene(BenchmarkScene{.name = "test", .mesh_num = 2, .grid_size = 1, .instance_num = 1, .material_num = 1});
+  CHECK_UNARY(IsWithinElementRange(*scene, Options{}));
+  const auto face_num = scene->mMeshes[0]->mNumFaces;
+  scene->mMeshes[0]->mNumFaces = 0x60000000;
+  CHECK_FALSE(IsWithinElementRange(*scene, Options{}));
+  // lods may not shrink below lod0 size whatever the target ratios are
+  scene->mMeshes[0]->mNumFaces = 0x20000000;
+  CHECK_UNARY(IsWithinElementRange(*scene, Options{}));
+  Options lod_options;
+  lod_options.lod_target_ratios = {0.5f, 0.25f};
+  CHECK_FALSE(IsWithinElementRange(*scene, lod_options));
+  scene->mMeshes[0]->mNumFaces = face_num;
+}
+TEST_CASE("spatial cells") {
+  using namespace modelconv;
+  // 64 instances of 4 flat 1x1 meshes on an 8x8 grid, 4x4 instances per cell
+  const auto scene = CreateBenchmarkScene(BenchmarkScene{.name = "cells", .mesh_num = 4, .grid_size = 2, .instance_num = 16, .material_num = 2});
+  Options options;
+  options.spatial_cell_size = 4.0f;
+  ConversionMetrics metrics;
+  std::vector<std::string> output_files;
+  std::filesystem::remove_all("output/cells");
+  ConvertScene(*scene, false, "cells", "", "output/cells", options, &metrics, &output_files);
+  CHECK_EQ(output_files.size(), 5);
+  const auto index = ReadTestFile("output/cells/cells.bin");
+  const auto cell_section = FindSection(index.data(), SectionType::kCell);
+  CHECK_NE(cell_section, nullptr);
+  CHECK_EQ(cell_section->size_in_bytes, sizeof(CellEntry) * 4);
+  CHECK_EQ(FindSection(index.data(), SectionType::kMaterial)->size_in_bytes, sizeof(MaterialEntry) * 2);
+  const auto cells = GetSectionData<CellEntry>(index.data(), *cell_section);
+  const auto strings = GetSectionData<char>(index.data(), *FindSection(index.data(), SectionType::kString));
+  for (uint32_t i = 0; i < 4; i++) {
+    const auto& cell = cells[i];
+    CHECK_EQ(cell.coord[1], 0);
+    CHECK_EQ(cell.instance_num, 16);
+    CHECK_EQ(cell.mesh_num, 4);
+    CHECK_EQ(cell.chunk_num, 1);
+    const std::string cell_filename(strings + cell.path_offset, cell.path_len);
+    const auto cell_file = ReadTestFile("output/cells/" + cell_filename);
+    CHECK_EQ(cell_file.size(), cell.file_size_in_bytes);
+    const auto instance_section = FindSection(cell_file.data(), SectionType::kInstanceBounds);
+    CHECK_EQ(instance_section->size_in_bytes, sizeof(InstanceBoundsEntry) * 16);
+    const auto instances = GetSectionData<InstanceBoundsEntry>(cell_file.data(), *instance_section);
+    for (uint32_t j = 0; j < 16; j++) {
+      for (uint32_t k = 0; k < 3; k += 2) {
+        const auto center = (instances[j].aabb_min[k] + instances[j].aabb_max[k]) * 0.5f;
+        CHECK_EQ(static_cast<int32_t>(std::floor(center / options.spatial_cell_size)), cell.coord[k]);
+        CHECK_GE(instances[j].aabb_min[k], cell.aabb_min[k]);
+        CHECK_LE(instances[j].aabb_max[k], cell.aabb_max[k]);
+      }
+    }
+  }
+}
+#ifdef MODELCONV_COUNT_ALLOCATIONS
+// global operator new/delete of the test executable are replaced to measure peak allocation of pipeline stages
+namespace {
+std::atomic<uint64_t> allocated_in_bytes{0};
+std::atomic<uint64_t> peak_allocated_in_bytes{0};
+constexpr std::size_t kAllocationHeaderSize = alignof(std::max_align_t);
+auto ResetPeakAllocation() {
+  const auto allocated = allocated_in_bytes.load();
+  peak_allocated_in_bytes = allocated;
+  return allocated;
+}
+} // namespace anonymous
+void* operator new(const std::size_t size) {
+  auto head = static_cast<uint8_t*>(std::malloc(size + kAllocationHeaderSize));
+  if (head == nullptr) { throw std::bad_alloc(); }
+  memcpy(head, &size, sizeof(size));
+  const auto allocated = allocated_in_bytes.fetch_add(size) + size;
+  auto peak = peak_allocated_in_bytes.load();
+  while (allocated > peak && !peak_allocated_in_bytes.compare_exchange_weak(peak, allocated)) {}
+  return head + kAllocationHeaderSize;
+}
+void operator delete(void* ptr) noexcept {
+  if (ptr == nullptr) { return; }
+  auto head = static_cast<uint8_t*>(ptr) - kAllocationHeaderSize;
+  std::size_t size = 0;
+  memcpy(&size, head, sizeof(size));
+  allocated_in_bytes.fetch_sub(size);
+  std::free(head);
+}
+void operator delete(void* ptr, const std::size_t) noexcept {
+  operator delete(ptr);
+}
+TEST_CASE("peak allocation") {
+  using namespace modelconv;
+  const auto scene = CreateBenchmarkScene(BenchmarkScene{.name = "test", .mesh_num = 8, .grid_size = 127, .instance_num = 1, .material_num = 1});
+  std::vector<PerDrawCallModelIndexSet> per_draw_call_model_index_set(scene->mNumMeshes);
+  // small allocations such as log formatting
+  const uint64_t kMarginInBytes = 64 * 1024;
+  // vertex and index data is written once into pre-sized buffers, without temporary copies of them
+  auto allocated = ResetPeakAllocation();
+  const auto mesh_buffers = GatherMeshData(1, scene->mNumMeshes, scene->mMeshes, &per_draw_call_model_index_set);
+  const auto mesh_buffers_size_in_bytes = mesh_buffers.index_buffer.capacity() * sizeof(uint32_t)
+      + (mesh_buffers.vertex_buffer_position.capacity() + mesh_buffers.vertex_buffer_normal.capacity() + mesh_buffers.vertex_buffer_tangent.capacity() + mesh_buffers.vertex_buffer_texcoord.capacity()) * sizeof(float)
+      + mesh_buffers.vertex_buffer_tangent_sign.capacity();
+  CHECK_EQ(mesh_buffers.vertex_buffer_position.capacity(), 8 * 128 * 128 * 3);
+  CHECK_LE(peak_allocated_in_bytes.load() - allocated, mesh_buffers_size_in_bytes + kMarginInBytes);
+  allocated = ResetPeakAllocation();
+  std::vector<uint8_t> narrowed_index_buffer;
+  CreateIndexStream(true, false, mesh_buffers.index_buffer, &narrowed_index_buffer, &per_draw_call_model_index_set);
+  CHECK_EQ(narrowed_index_buffer.size(), mesh_buffers.index_buffer.size() * sizeof(uint16_t));
+  CHECK_LE(peak_allocated_in_bytes.load() - allocated, narrowed_index_buffer.size() + kMarginInBytes);
+  allocated = ResetPeakAllocation();
+  const auto transform_matrix_list = GetTransformMatrixList(scene->mRootNode, per_draw_call_model_index_set.data());
+  const auto [transform_index_list_offset, transform_index_list] = FlattenTransformIndexLists(per_draw_call_model_index_set);
+  CHECK_EQ(transform_index_list.capacity(), 8);
+  CHECK_LE(peak_allocated_in_bytes.load() - allocated, 2 * transform_matrix_list.capacity() * sizeof(float) + kMarginInBytes);
+}
+#endif